@@ -2,6 +2,8 @@ TARGET = AAt-SIPP-m
 CONFIG   += console
 CONFIG   -= app_bundle
 QMAKE_CXXFLAGS += -std=c++0x
+QMAKE_CXXFLAGS += -pthread
+LIBS += -pthread
 TEMPLATE = app
 win32 {
 QMAKE_LFLAGS += -static -static-libgcc -static-libstdc++
@@ -13,7 +15,16 @@ SOURCES += main.cpp \
     map.cpp \
     config.cpp \
     aa_sipp.cpp \
+    openlist.cpp \
+    closelist.cpp \
     constraints.cpp \
+    sectionbuffer.cpp \
+    sectionbuffer_avx2.cpp \
+    heuristic.cpp \
+    conflictchecker.cpp \
+    batch.cpp \
+    service.cpp \
+    planner.cpp \
     task.cpp \
     dynamicobstacles.cpp
 
@@ -26,8 +37,17 @@ HEADERS += \
     map.h \
     config.h \
     aa_sipp.h \
+    openlist.h \
+    closelist.h \
     structs.h \
     constraints.h \
+    sectionbuffer.h \
+    sectionkernel.h \
+    heuristic.h \
+    conflictchecker.h \
+    batch.h \
+    service.h \
+    planner.h \
     lineofsight.h \
     task.h \
     dynamicobstacles.h
@@ -3,22 +3,27 @@
 AA_SIPP::AA_SIPP(const Config &config)
 {
     this->config = std::make_shared<const Config> (config);
-    openSize = 0;
     constraints = nullptr;
+    lineofsight = nullptr;
+    distances = nullptr;
+    landmarks = nullptr;
+    truedistances = nullptr;
+    cancelled = nullptr;
+    detour = 1;
+    width = 0;
+    seed = -1;
+    heuristicthreads = 0;
 }
 
 AA_SIPP::~AA_SIPP()
 {
 }
 
-bool AA_SIPP::stopCriterion(const Node &curNode, Node &goalNode)
+bool AA_SIPP::stopCriterion(const SearchNode &curNode, SearchNode &goalNode)
 {
-    if(openSize == 0)
-    {
-        std::cout << "OPEN list is empty! ";
+    if(open.empty())
         return true;
-    }
-    if(curNode.i == curagent.goal_i && curNode.j == curagent.goal_j && curNode.interval.end == CN_INFINITY)
+    if(curNode.i == curagent.goal_i && curNode.j == curagent.goal_j && curNode.interval_end == CN_INFINITY)
     {
         if(!config->planforturns || curagent.goal_heading == CN_HEADING_WHATEVER)
             goalNode = curNode;
@@ -41,13 +46,41 @@ double AA_SIPP::getCost(int a_i, int a_j, int b_i, int b_j)
 
 double AA_SIPP::getHValue(int i, int j)
 {
+    double h;
     if(config->allowanyangle || config->connectedness > 3) //euclid
-        return (sqrt(pow(i - curagent.goal_i, 2) + pow(j - curagent.goal_j, 2)))/curagent.mspeed;
+        h = (sqrt(pow(i - curagent.goal_i, 2) + pow(j - curagent.goal_j, 2)))/curagent.mspeed;
     else if(config->connectedness == 2)//manhattan
-        return (abs(i - curagent.goal_i) + abs(j - curagent.goal_j))/curagent.mspeed;
+        h = (abs(i - curagent.goal_i) + abs(j - curagent.goal_j))/curagent.mspeed;
     else //k=3, use diagonal
-        return (abs(abs(i - curagent.goal_i) - abs(j - curagent.goal_j)) + sqrt(2.0)*std::min(abs(i - curagent.goal_i), abs(j - curagent.goal_j)))/curagent.mspeed;
+        h = (abs(abs(i - curagent.goal_i) - abs(j - curagent.goal_j)) + sqrt(2.0)*std::min(abs(i - curagent.goal_i), abs(j - curagent.goal_j)))/curagent.mspeed;
+    if(distances)//true distance along the grid moves
+        h = std::max(h, (*distances)[i*width + j]/(detour*curagent.mspeed));
+    //the triangle inequality for each landmark, the distances are rounded to floats, so the bounds are loosened by their precision.
+    //The landmark distances are along the grid moves as well, so in any-angle mode they have the same caveat as 'distances'.
+    if(landmarks && !goaldistances.empty())
+    {
+        unsigned int cells(landmarks->distances.size()/landmarks->cells.size());
+        for(unsigned int l = 0; l < goaldistances.size(); l++)
+        {
+            double a(landmarks->distances[l*cells + i*width + j]), b(goaldistances[l]);
+            if(a >= CN_INFINITY || b >= CN_INFINITY)
+            {
+                if(a < CN_INFINITY || b < CN_INFINITY)//the cell and the goal are not connected
+                    return CN_INFINITY;
+                continue;
+            }
+            h = std::max(h, (fabs(a - b) - FLT_EPSILON*std::max(a, b))/(detour*curagent.mspeed));
+        }
+    }
+    return h;
+}
 
+double AA_SIPP::getDetour(int k)
+{
+    //the neighbouring directions of the moves differ by 90, 45, atan(1/2) and atan(1/3) degrees for k = 2..5,
+    //and a path of two such moves is at most 1/cos(angle/2) times longer than the straight line between its ends
+    double angle = k == 2 ? PI/2 : k == 3 ? PI/4 : k == 4 ? atan(0.5) : atan(1.0/3);
+    return 1/cos(angle/2);
 }
 
 double AA_SIPP::getRCost(double headingA, double headingB)
@@ -58,7 +91,7 @@ double AA_SIPP::getRCost(double headingA, double headingB)
         return 0;
 }
 
-double AA_SIPP::calcHeading(const Node &node, const Node &son)
+double AA_SIPP::calcHeading(const SearchNode &node, const SearchNode &son)
 {
     double heading = acos((son.j - node.j)/getCost(son.i, son.j, node.i, node.j))*180/PI;
     if(node.i < son.i)
@@ -66,17 +99,16 @@ double AA_SIPP::calcHeading(const Node &node, const Node &son)
     return heading;
 }
 
-std::list<Node> AA_SIPP::findSuccessors(const Node curNode, const Map &map)
+void AA_SIPP::findSuccessors(const SearchNode &curNode, const Map &map)
 {
-    Node newNode, angleNode;
-    std::list<Node> successors;
+    SearchNode newNode, angleNode;
+    successors.clear();
     std::vector<double> EAT;
     std::vector<SafeInterval> intervals;
     double h_value;
-    auto parent = &(close.find(curNode.i*map.width + curNode.j)->second);
-    std::vector<Node> moves = map.getValidMoves(curNode.i, curNode.j, config->connectedness, curagent.size);
+    int parent = close.first(curNode.i, curNode.j);
+    map.getValidMoves(curNode.i, curNode.j, config->connectedness, *lineofsight, moves);
     for(auto m:moves)
-        if(lineofsight.checkTraversability(curNode.i + m.i,curNode.j + m.j,map))
         {
             newNode.i = curNode.i + m.i;
             newNode.j = curNode.j + m.j;
@@ -85,135 +117,81 @@ std::list<Node> AA_SIPP::findSuccessors(const Node curNode, const Map &map)
             angleNode = curNode; //the same state, but with extended g-value
             angleNode.g += getRCost(angleNode.heading, newNode.heading) + config->additionalwait;//to compensate the amount of time required for rotation
             newNode.g = angleNode.g + m.g/curagent.mspeed;
-            newNode.Parent = &angleNode;
+            newNode.Parent = parent;
             h_value = getHValue(newNode.i, newNode.j);
 
-            if(angleNode.g <= angleNode.interval.end)
+            if(angleNode.g <= angleNode.interval_end)
             {
-                intervals = constraints->findIntervals(newNode, EAT, close, map);
+                intervals = constraints->findIntervals(newNode, angleNode, EAT, close, map);
                 for(unsigned int k = 0; k < intervals.size(); k++)
                 {
-                    newNode.interval = intervals[k];
+                    newNode.setInterval(intervals[k]);
                     newNode.Parent = parent;
                     newNode.g = EAT[k];
                     newNode.F = newNode.g + h_value;
-                    successors.push_front(newNode);
+                    successors.push_back(newNode);
                 }
             }
             if(config->allowanyangle)
             {
                 newNode = resetParent(newNode, curNode, map);
-                if(newNode.Parent->i != parent->i || newNode.Parent->j != parent->j)
+                if(newNode.Parent != parent)
                 {
-                    angleNode = *newNode.Parent;
-                    newNode.heading = calcHeading(*newNode.Parent, newNode);//new heading with respect to new parent
+                    angleNode = close.getNode(newNode.Parent);
+                    newNode.heading = calcHeading(angleNode, newNode);//new heading with respect to new parent
                     angleNode.g += getRCost(angleNode.heading, newNode.heading) + config->additionalwait;//count new additional time required for rotation
                     newNode.g += getRCost(angleNode.heading, newNode.heading) + config->additionalwait;
-                    newNode.Parent = &angleNode;
-                    if(angleNode.g > angleNode.interval.end)
+                    if(angleNode.g > angleNode.interval_end)
                         continue;
-                    intervals = constraints->findIntervals(newNode, EAT, close, map);
+                    intervals = constraints->findIntervals(newNode, angleNode, EAT, close, map);
                     for(unsigned int k = 0; k < intervals.size(); k++)
                     {
-                        newNode.interval = intervals[k];
-                        newNode.Parent = parent->Parent;
+                        newNode.setInterval(intervals[k]);
+                        newNode.Parent = curNode.Parent;
                         newNode.g = EAT[k];
                         newNode.F = newNode.g + h_value;
-                        successors.push_front(newNode);
+                        successors.push_back(newNode);
                     }
                 }
             }
         }
-
-    return successors;
-}
-
-Node AA_SIPP::findMin(int size)
-{
-    Node min;
-    min.F = std::numeric_limits<double>::max();
-    for(int i = 0; i < size; i++)
-    {
-        if(!open[i].empty() && open[i].begin()->F - CN_EPSILON < min.F)
-        {
-            if (fabs(open[i].begin()->F - min.F) < CN_EPSILON)
-            {
-                if (min.g < open[i].begin()->g)
-                    min = *open[i].begin();
-            }
-            else
-                min = *open[i].begin();
-        }
-    }
-    return min;
 }
 
-void AA_SIPP::addOpen(Node &newNode)
+void AA_SIPP::addOpen(const SearchNode &newNode)
 {
-    if (open[newNode.i].empty())
-    {
-        open[newNode.i].push_back(newNode);
-        openSize++;
-        return;
-    }
-
-    std::list<Node>::iterator iter, pos, delpos;
-    bool posFound(false);
-    pos = open[newNode.i].end();
-    for(iter = open[newNode.i].begin(); iter != open[newNode.i].end(); ++iter)
+    int replaced(-1);
+    int slot = open.findState(newNode.i, newNode.j, newNode.interval_id);
+    while(slot >= 0)
     {
-        if ((newNode.F - CN_EPSILON < iter->F) && !posFound)
+        int nextSlot = open.findState(newNode.i, newNode.j, newNode.interval_id, slot);
+        const SearchNode &existing = open.getNode(slot);
+        if((existing.g - newNode.g + getRCost(existing.heading, newNode.heading)) < CN_EPSILON)//if existing state dominates new one
+            return;
+        if((newNode.g - existing.g + getRCost(existing.heading, newNode.heading)) < CN_EPSILON)//if new state dominates the existing one
         {
-            if (fabs(iter->F - newNode.F) < CN_EPSILON)
+            if(replaced < 0)
             {
-                if (newNode.g > iter->g)
-                {
-                    pos = iter;
-                    posFound = true;
-                }
+                open.update(slot, newNode);
+                replaced = slot;
             }
             else
-            {
-                pos = iter;
-                posFound = true;
-            }
-        }
-
-        if (iter->j == newNode.j && iter->interval.id == newNode.interval.id)
-        {
-            if((iter->g - newNode.g + getRCost(iter->heading, newNode.heading)) < CN_EPSILON)//if existing state dominates new one
-                return;
-            if((newNode.g - iter->g + getRCost(iter->heading, newNode.heading)) < CN_EPSILON)//if new state dominates the existing one
-            {
-                if(pos == iter)
-                {
-                    iter->F = newNode.F;
-                    iter->g = newNode.g;
-                    iter->interval = newNode.interval;
-                    iter->Parent = newNode.Parent;
-                    iter->heading = newNode.heading;
-                    return;
-                }
-                delpos = iter;
-                iter--;
-                open[newNode.i].erase(delpos);
-                openSize--;
-            }
+                open.remove(slot);
         }
+        slot = nextSlot;
     }
-    open[newNode.i].insert(pos, newNode);
-    openSize++;
+    if(replaced < 0)
+        open.push(newNode);
     return;
 }
 
-void AA_SIPP::setPriorities(const Task& task)
+void AA_SIPP::setPriorities(const Task& task, int prioritization)
 {
     current_priorities.clear();
     current_priorities.resize(task.getNumberOfAgents(), -1);
-    if(config->initialprioritization == CN_IP_FIFO)
+    if(prioritization == CN_IP_FIFO)
         for(int i = 0; i < task.getNumberOfAgents(); i++)
             current_priorities[i] = i;
-    else if(config->initialprioritization != CN_IP_RANDOM)
+    else if(prioritization != CN_IP_RANDOM)
     {
         std::vector<double> dists(task.getNumberOfAgents(), -1);
         for(int i = 0; i < task.getNumberOfAgents(); i++)
@@ -229,7 +207,7 @@ void AA_SIPP::setPriorities(const Task& task)
                     min_i = i;
                     mindist = dists[i];
                 }
-            if(config->initialprioritization == CN_IP_LONGESTF)
+            if(prioritization == CN_IP_LONGESTF)
                 current_priorities[k] = min_i;
             else
                 current_priorities[task.getNumberOfAgents() - k - 1] = min_i;
@@ -241,11 +219,16 @@ void AA_SIPP::setPriorities(const Task& task)
     {
         for(int i = 0; i < task.getNumberOfAgents(); i++)
             current_priorities[i] = i;
-        std::mt19937 g(rand());
+        std::mt19937 g(getSeed());
         std::shuffle(current_priorities.begin(), current_priorities.end(), g);
     }
 }
 
+unsigned int AA_SIPP::getSeed()
+{
+    return seed < 0 ? rand() : generator();
+}
+
 bool AA_SIPP::changePriorities(int bad_i)
 {
     if(config->rescheduling == CN_RE_NO)
@@ -272,7 +255,7 @@ bool AA_SIPP::changePriorities(int bad_i)
     }
     else //random
     {
-        std::mt19937 g(rand());
+        std::mt19937 g(getSeed());
         std::shuffle(current_priorities.begin(),current_priorities.end(), g);
         bool unique = false;
         int maxtries(1000000), tries(0);
@@ -300,9 +283,90 @@ bool AA_SIPP::changePriorities(int bad_i)
     }
 }
 
+void AA_SIPP::prepareMap(Map &map, const Task &task, const Config &config)
+{
+    for(unsigned int k = 0; k < task.getNumberOfAgents(); k++)
+        map.prepareValidMoves(config.connectedness, LineOfSight::get(task.getAgent(k).size));
+    if(config.heuristic == CN_HEUR_LANDMARKS)
+        for(unsigned int k = 0; k < task.getNumberOfAgents(); k++)
+            map.prepareLandmarks(config.connectedness, LineOfSight::get(task.getAgent(k).size));
+}
+
 SearchResult AA_SIPP::startSearch(Map &map, Task &task, DynamicObstacles &obstacles)
 {
 
+#ifdef __linux__
+    timeval begin, end;
+    gettimeofday(&begin, NULL);
+#else
+    LARGE_INTEGER begin, end, freq;
+    QueryPerformanceCounter(&begin);
+    QueryPerformanceFrequency(&freq);
+#endif
+    double timespent(0);
+    priorities.clear();
+    open.resize(map.width, map.height);
+    close.resize(map.width, map.height);
+    setPriorities(task, config->initialprioritization);
+    prepareMap(map, task, *config);
+    width = map.width;
+    //any-angle paths are the paths of grid moves shortened by line-of-sight checks, so the grid distances are scaled down
+    //by the longest detour of the moves. It is a lower bound unless a line squeezes where no chain of grid moves can pass,
+    //so in any-angle mode the true distance heuristics are not admissible and may lead to suboptimal paths (see README).
+    detour = config->allowanyangle ? getDetour(config->connectedness) : 1;
+    truedistances = &heuristic;
+    if(config->heuristic == CN_HEUR_DIJKSTRA)
+        heuristic.start(map, task, current_priorities, config->connectedness, heuristicthreads);
+    //a layer built here is a part of the search, so it counts towards the runtime and the time limit
+    std::shared_ptr<const Constraints> layer = obstacleLayer ? obstacleLayer : buildObstacleLayer(map, obstacles);
+#ifdef __linux__
+    gettimeofday(&end, NULL);
+    timespent = (end.tv_sec - begin.tv_sec) + static_cast<double>(end.tv_usec - begin.tv_usec) / 1000000;
+#else
+    QueryPerformanceCounter(&end);
+    timespent = static_cast<double long>(end.QuadPart-begin.QuadPart) / freq.QuadPart;
+#endif
+    int tries;
+    if(config->portfolio != 1)
+        tries = startPortfolio(map, task, layer, config->timelimit - timespent);
+    else
+        tries = search(map, task, layer, config->timelimit - timespent);
+    heuristic.stop();
+    distances = nullptr;
+    landmarks = nullptr;
+
+#ifdef __linux__
+    gettimeofday(&end, NULL);
+    sresult.runtime = (end.tv_sec - begin.tv_sec) + static_cast<double>(end.tv_usec - begin.tv_usec) / 1000000;
+#else
+    QueryPerformanceCounter(&end);
+    sresult.runtime = static_cast<double long>(end.QuadPart-begin.QuadPart) / freq.QuadPart;
+#endif
+    sresult.tries = tries;
+    if(sresult.pathfound)
+    {
+        std::vector<conflict> confs = CheckConflicts(task);
+        for(unsigned int i = 0; i < confs.size(); i++)
+        {
+            std::ostringstream line;
+            line<<confs[i].i<<" "<<confs[i].j<<" "<<confs[i].g<<" "<<confs[i].agent1<<" "<<confs[i].agent2;
+            message(line.str());
+        }
+    }
+    return sresult;
+}
+
+std::shared_ptr<const Constraints> AA_SIPP::buildObstacleLayer(const Map &map, const DynamicObstacles &obstacles)
+{
+    std::shared_ptr<Constraints> layer = std::make_shared<Constraints>(map.width, map.height);
+    for(int k = 0; k < obstacles.getNumberOfObstacles(); k++)
+        layer->addConstraints(obstacles.getSections(k), obstacles.getSize(k), obstacles.getMSpeed(k), map);
+    layer->compact();
+    return layer;
+}
+
+int AA_SIPP::search(const Map &map, const Task &task, std::shared_ptr<const Constraints> layer, double timelimit)
+{
 #ifdef __linux__
     timeval begin, end;
     gettimeofday(&begin, NULL);
@@ -314,45 +378,70 @@ SearchResult AA_SIPP::startSearch(Map &map, Task &task, DynamicObstacles &obstac
     bool solution_found(false);
     int tries(0), bad_i(0);
     double timespent(0);
-    priorities.clear();
-    open.resize(map.height);
-    setPriorities(task);
-    do
+    constraints = new Constraints(*layer);//the layer itself is shared, so the search writes to its own copy
+    for(int k = 0; k < task.getNumberOfAgents(); k++)
     {
-        constraints = new Constraints(map.width, map.height);
-        for(int k = 0; k < obstacles.getNumberOfObstacles(); k++)
+        curagent = task.getAgent(k);
+        constraints->setParams(curagent.size, curagent.mspeed, curagent.rspeed, config->planforturns, config->inflatecollisionintervals);
+        lineofsight = &LineOfSight::get(curagent.size);
+        if(config->startsafeinterval > 0)
         {
-            constraints->addConstraints(obstacles.getSections(k), obstacles.getSize(k), obstacles.getMSpeed(k), map);
+            auto cells = lineofsight->getCells(curagent.start_i,curagent.start_j);
+            constraints->addStartConstraint(curagent.start_i, curagent.start_j, config->startsafeinterval, cells, curagent.size);
         }
-        sresult.pathInfo.clear();
-        sresult.pathInfo.resize(task.getNumberOfAgents());
-        sresult.agents = task.getNumberOfAgents();
-        sresult.agentsSolved = 0;
+    }
+    //checkpoints[p] is the state of the constraints before the agent at position p was planned. The paths of the agents
+    //don't depend on the lower priorities, so the prefix of the orderings shared with the previous try is kept as is.
+    std::vector<constraintsCheckpoint> checkpoints = {constraints->getCheckpoint()};
+    std::vector<int> planned;
+    sresult.pathInfo.clear();
+    sresult.pathInfo.resize(task.getNumberOfAgents());
+    sresult.agents = task.getNumberOfAgents();
+    do
+    {
+        unsigned int prefix(0);
+        while(prefix < planned.size() && planned[prefix] == current_priorities[prefix])
+            prefix++;
+        constraints->rollback(checkpoints[prefix]);
+        checkpoints.resize(prefix + 1);
+        planned.resize(prefix);
+        sresult.agentsSolved = prefix;
         sresult.flowtime = 0;
         sresult.makespan = 0;
-        for(int k = 0; k < task.getNumberOfAgents(); k++)
+        for(unsigned int p = 0; p < prefix; p++)
         {
-            curagent = task.getAgent(k);
-            constraints->setParams(curagent.size, curagent.mspeed, curagent.rspeed, config->planforturns, config->inflatecollisionintervals);
-            lineofsight.setSize(curagent.size);
-            if(config->startsafeinterval > 0)
-            {
-                auto cells = lineofsight.getCells(curagent.start_i,curagent.start_j);
-                constraints->addStartConstraint(curagent.start_i, curagent.start_j, config->startsafeinterval, cells, curagent.size);
-            }
+            sresult.flowtime += sresult.pathInfo[planned[p]].pathlength;
+            sresult.makespan = std::max(sresult.makespan, sresult.pathInfo[planned[p]].pathlength);
         }
-        for(unsigned int numOfCurAgent = 0; numOfCurAgent < task.getNumberOfAgents(); numOfCurAgent++)
+        for(unsigned int p = prefix; p < task.getNumberOfAgents(); p++)
+            sresult.pathInfo[current_priorities[p]] = ResultPathInfo();
+        for(unsigned int numOfCurAgent = prefix; numOfCurAgent < task.getNumberOfAgents(); numOfCurAgent++)
         {
+            if(cancelled && *cancelled)
+                break;
             curagent = task.getAgent(current_priorities[numOfCurAgent]);
             constraints->setParams(curagent.size, curagent.mspeed, curagent.rspeed, config->planforturns, config->inflatecollisionintervals);
-            lineofsight.setSize(curagent.size);
+            lineofsight = &LineOfSight::get(curagent.size);
+            if(config->heuristic == CN_HEUR_DIJKSTRA)
+                distances = &truedistances->get(current_priorities[numOfCurAgent]);
+            else if(config->heuristic == CN_HEUR_LANDMARKS)
+            {
+                landmarks = map.getLandmarks(config->connectedness, curagent.size);
+                goaldistances.clear();
+                for(unsigned int l = 0; l < landmarks->cells.size(); l++)
+                    goaldistances.push_back(landmarks->distances[l*map.width*map.height + curagent.goal_i*map.width + curagent.goal_j]);
+            }
             if(config->startsafeinterval > 0)
             {
-                auto cells = lineofsight.getCells(curagent.start_i, curagent.start_j);
+                auto cells = lineofsight->getCells(curagent.start_i, curagent.start_j);
                 constraints->removeStartConstraint(cells, curagent.start_i, curagent.start_j);
             }
             if(findPath(current_priorities[numOfCurAgent], map))
+            {
                 constraints->addConstraints(sresult.pathInfo[current_priorities[numOfCurAgent]].sections, curagent.size, curagent.mspeed, map);
+                checkpoints.push_back(constraints->getCheckpoint());
+                planned.push_back(current_priorities[numOfCurAgent]);
+            }
             else
             {
                 bad_i = current_priorities[numOfCurAgent];
@@ -361,8 +450,6 @@ SearchResult AA_SIPP::startSearch(Map &map, Task &task, DynamicObstacles &obstac
             if(numOfCurAgent + 1 == task.getNumberOfAgents())
                 solution_found = true;
         }
-
-        delete constraints;
         tries++;
 #ifdef __linux__
     gettimeofday(&end, NULL);
@@ -371,39 +458,92 @@ SearchResult AA_SIPP::startSearch(Map &map, Task &task, DynamicObstacles &obstac
     QueryPerformanceCounter(&end);
     timespent = static_cast<double long>(end.QuadPart-begin.QuadPart) / freq.QuadPart;
 #endif
-        if(timespent > config->timelimit)
+        if(timespent > timelimit || (cancelled && *cancelled))
             break;
     } while(changePriorities(bad_i) && !solution_found);
+    delete constraints;
+    constraints = nullptr;
+    return tries;
+}
 
+void AA_SIPP::setVariant(const Task &task, int variant)
+{
+    //the first worker plans exactly as the sequential search does, the next ones start from the other rule-based orderings
+    //and the rest of them start from random shuffles, each worker with its own seed
+    std::vector<int> rules = {config->initialprioritization};
+    for(int prioritization : {CN_IP_SHORTESTF, CN_IP_LONGESTF, CN_IP_FIFO})
+        if(prioritization != config->initialprioritization)
+            rules.push_back(prioritization);
+    if(variant > 0)
+    {
+        seed = variant;
+        generator.seed(seed);
+    }
+    priorities.clear();
+    setPriorities(task, variant < int(rules.size()) ? rules[variant] : CN_IP_RANDOM);
+}
 
-#ifdef __linux__
-    gettimeofday(&end, NULL);
-    sresult.runtime = (end.tv_sec - begin.tv_sec) + static_cast<double>(end.tv_usec - begin.tv_usec) / 1000000;
-#else
-    QueryPerformanceCounter(&end);
-    sresult.runtime = static_cast<double long>(end.QuadPart-begin.QuadPart) / freq.QuadPart;
-#endif
-    sresult.tries = tries;
-    if(sresult.pathfound)
+int AA_SIPP::startPortfolio(const Map &map, const Task &task, std::shared_ptr<const Constraints> layer, double timelimit)
+{
+    int threads = config->portfolio > 0 ? config->portfolio : std::max(int(std::thread::hardware_concurrency()), 1);
+    std::atomic<bool> solved(false);
+    std::atomic<int> winner(-1);
+    std::vector<std::unique_ptr<AA_SIPP>> workers;
+    std::vector<std::thread> pool;
+    for(int w = 0; w < threads; w++)
     {
-        std::vector<conflict> confs = CheckConflicts(task);
-        for(unsigned int i = 0; i < confs.size(); i++)
-            std::cout<<confs[i].i<<" "<<confs[i].j<<" "<<confs[i].g<<" "<<confs[i].agent1<<" "<<confs[i].agent2<<"\n";
+        workers.emplace_back(new AA_SIPP(*config));
+        AA_SIPP &worker = *workers.back();
+        worker.open.resize(map.width, map.height);
+        worker.close.resize(map.width, map.height);
+        worker.width = width;
+        worker.detour = detour;
+        worker.truedistances = &heuristic;
+        worker.cancelled = &solved;
+        worker.handler = handler;
+        worker.setVariant(task, w);
     }
-    return sresult;
+    for(int w = 0; w < threads; w++)
+        pool.emplace_back([&, w]()
+        {
+            AA_SIPP &worker = *workers[w];
+            worker.sresult.tries = worker.search(map, task, layer, timelimit);
+            int none(-1);
+            if(worker.sresult.agentsSolved == task.getNumberOfAgents() && winner.compare_exchange_strong(none, w))
+                solved = true;
+        });
+    for(std::thread &thread : pool)
+        thread.join();
+
+    //the first complete solution wins, otherwise the result with the most of the agents solved is taken
+    int best(winner), tries(0);
+    for(int w = 0; w < threads; w++)
+    {
+        const SearchResult &result = workers[w]->sresult;
+        tries += result.tries;
+        if(winner < 0 && (best < 0 || result.agentsSolved > workers[best]->sresult.agentsSolved
+                          || (result.agentsSolved == workers[best]->sresult.agentsSolved && result.flowtime < workers[best]->sresult.flowtime)))
+            best = w;
+    }
+    sresult = workers[best]->sresult;
+    return tries;
 }
 
 
-Node AA_SIPP::resetParent(Node current, Node Parent, const Map &map)
+SearchNode AA_SIPP::resetParent(const SearchNode &current, const SearchNode &parent, const Map &map)
 {
-    if(Parent.Parent == nullptr || (current.i == Parent.Parent->i && current.j == Parent.Parent->j))
+    if(parent.Parent < 0)
+        return current;
+    const SearchNode &grandParent = close.getNode(parent.Parent);
+    if(current.i == grandParent.i && current.j == grandParent.j)
         return current;
-    if(lineofsight.checkLine(Parent.Parent->i, Parent.Parent->j, current.i, current.j, map))
+    SearchNode node(current);
+    if(lineofsight->checkLine(grandParent.i, grandParent.j, current.i, current.j, map))
     {
-        current.g = Parent.Parent->g + getCost(Parent.Parent->i, Parent.Parent->j, current.i, current.j)/curagent.mspeed;
-        current.Parent = Parent.Parent;
+        node.g = grandParent.g + getCost(grandParent.i, grandParent.j, current.i, current.j)/curagent.mspeed;
+        node.Parent = parent.Parent;
     }
-    return current;
+    return node;
 }
 
 bool AA_SIPP::findPath(unsigned int numOfCurAgent, const Map &map)
@@ -418,26 +558,25 @@ bool AA_SIPP::findPath(unsigned int numOfCurAgent, const Map &map)
     QueryPerformanceFrequency(&freq);
 #endif
     close.clear();
-    for(unsigned int i = 0; i< open.size(); i++)
-        open[i].clear();
+    open.clear();
+    constraints->compact();
     ResultPathInfo resultPath;
-    openSize = 0;
-    constraints->resetSafeIntervals(map.width, map.height);
     constraints->updateCellSafeIntervals({curagent.start_i, curagent.start_j});
-    Node curNode(curagent.start_i, curagent.start_j, 0, 0), goalNode(curagent.goal_i, curagent.goal_j, CN_INFINITY, CN_INFINITY);
+    SearchNode curNode(curagent.start_i, curagent.start_j, 0, 0), goalNode(curagent.goal_i, curagent.goal_j, CN_INFINITY, CN_INFINITY);
     curNode.F = getHValue(curNode.i, curNode.j);
-    curNode.interval = constraints->getSafeInterval(curNode.i, curNode.j, 0);
+    curNode.setInterval(constraints->getSafeInterval(curNode.i, curNode.j, 0));
     curNode.heading = curagent.start_heading;
-    open[curNode.i].push_back(curNode);
-    openSize++;
+    open.push(curNode);
+    unsigned int expansions(0);
     while(!stopCriterion(curNode, goalNode))
     {
-        curNode = findMin(map.height);
-        open[curNode.i].pop_front();
-        openSize--;
-        close.insert({curNode.i * map.width + curNode.j, curNode});
-        for(Node s:findSuccessors(curNode, map))
-            addOpen(s);
+        if(cancelled && ++expansions % CN_CANCEL_CHECK_PERIOD == 0 && *cancelled)//the result of this worker is not needed anymore
+            break;
+        curNode = open.pop();
+        close.add(curNode);
+        findSuccessors(curNode, map);
+        for(auto s = successors.rbegin(); s != successors.rend(); ++s)//the latest generated successors go first
+            addOpen(*s);
     }
     if(goalNode.g < CN_INFINITY)
     {
@@ -469,7 +608,8 @@ bool AA_SIPP::findPath(unsigned int numOfCurAgent, const Map &map)
         QueryPerformanceCounter(&end);
         resultPath.runtime = static_cast<double long>(end.QuadPart-begin.QuadPart) / freq.QuadPart;
 #endif
-        std::cout<<"Path for agent "<<curagent.id<<" not found!\n";
+        if(!cancelled || !*cancelled)//only the exhausted OPEN list ends the search without a path
+            message("OPEN list is empty! Path for agent " + curagent.id + " not found!");
         sresult.pathfound = false;
         resultPath.pathfound = false;
         resultPath.path.clear();
@@ -480,128 +620,39 @@ bool AA_SIPP::findPath(unsigned int numOfCurAgent, const Map &map)
     return resultPath.pathfound;
 }
 
+void AA_SIPP::message(const std::string &text) const
+{
+    if(handler)
+        handler(text);
+    else
+        std::cout<<text<<"\n";
+}
+
 std::vector<conflict> AA_SIPP::CheckConflicts(const Task &task)
 {
-    std::vector<conflict> conflicts(0);
-    conflict conf;
-    Node cur, check;
-    std::vector<std::vector<conflict>> positions;
-    positions.resize(sresult.agents);
-    for(unsigned int i = 0; i < sresult.agents; i++)
-    {
-        if(!sresult.pathInfo[i].pathfound)
-            continue;
-        positions[i].resize(0);
-        int k = 0;
-        double part = 1;
-        for(unsigned int j = 1; j < sresult.pathInfo[i].sections.size(); j++)
-        {
-            cur = sresult.pathInfo[i].sections[j];
-            check = sresult.pathInfo[i].sections[j-1];
-            int di = cur.i - check.i;
-            int dj = cur.j - check.j;
-            double dist = (cur.g - check.g)*10;
-            int steps = (cur.g - check.g)*10;
-            if(dist - steps + part >= 1)
-            {
-                steps++;
-                part = dist - steps;
-            }
-            else
-                part += dist - steps;
-            double stepi = double(di)/dist;
-            double stepj = double(dj)/dist;
-            double curg = double(k)*0.1;
-            double curi = check.i + (curg - check.g)*di/(cur.g - check.g);
-            double curj = check.j + (curg - check.g)*dj/(cur.g - check.g);
-            conf.i = curi;
-            conf.j = curj;
-            conf.g = curg;
-            if(curg <= cur.g)
-            {
-                positions[i].push_back(conf);
-                k++;
-            }
-            while(curg <= cur.g)
-            {
-                if(curg + 0.1 > cur.g)
-                    break;
-                curi += stepi;
-                curj += stepj;
-                curg += 0.1;
-                conf.i = curi;
-                conf.j = curj;
-                conf.g = curg;
-                positions[i].push_back(conf);
-                k++;
-            }
-        }
-        if(double(k - 1)*0.1 < sresult.pathInfo[i].sections.back().g)
-        {
-            conf.i = sresult.pathInfo[i].sections.back().i;
-            conf.j = sresult.pathInfo[i].sections.back().j;
-            conf.g = sresult.pathInfo[i].sections.back().g;
-            positions[i].push_back(conf);
-        }
-    }
-    unsigned int max = 0;
-    double sumsize = 0;
-    for(unsigned int i = 0; i < positions.size(); i++)
-        if(positions[i].size() > max)
-            max = positions[i].size();
-    for(unsigned int i = 0; i < sresult.agents; i++)
-    {
-        for(unsigned int k = 0; k < max; k++)
-        {
-            for(unsigned int j = i + 1; j < sresult.agents; j++)
-            {
-                if(!sresult.pathInfo[j].pathfound || !sresult.pathInfo[i].pathfound)
-                    continue;
-                sumsize = task.getAgent(i).size + task.getAgent(j).size;
-                conflict a, b;
-                if(positions[i].size() > k)
-                    a = positions[i][k];
-                else
-                    a = positions[i].back();
-                if(positions[j].size() > k)
-                    b = positions[j][k];
-                else
-                    b = positions[j].back();
-                if(sqrt((a.i - b.i)*(a.i - b.i) + (a.j - b.j)*(a.j - b.j)) + CN_EPSILON < sumsize)
-                {
-                    std::cout<<i<<" "<<j<<" "<<a.i<<" "<<a.j<<" "<<b.i<<" "<<b.j<<" "<<sqrt((a.i - b.i)*(a.i - b.i) + (a.j - b.j)*(a.j - b.j))<<"\n";
-                    conf.i = b.i;
-                    conf.j = b.j;
-                    conf.agent1 = i;
-                    conf.agent2 = j;
-                    conf.g = b.g;
-                    conflicts.push_back(conf);
-                }
-            }
-        }
-    }
-    return conflicts;
+    ConflictChecker checker(config->validationthreads);
+    return checker.check(sresult, task);
 }
 
-void AA_SIPP::makePrimaryPath(Node curNode)
+void AA_SIPP::makePrimaryPath(SearchNode curNode)
 {
     hppath.clear();
     hppath.shrink_to_fit();
     std::list<Node> path;
-    path.push_front(curNode);
-    if(curNode.Parent != nullptr)
+    path.push_front(curNode.toNode());
+    if(curNode.Parent >= 0)
     {
-        curNode = *curNode.Parent;
-        if(curNode.Parent != nullptr)
+        curNode = close.getNode(curNode.Parent);
+        if(curNode.Parent >= 0)
         {
             do
             {
-                path.push_front(curNode);
-                curNode = *curNode.Parent;
+                path.push_front(curNode.toNode());
+                curNode = close.getNode(curNode.Parent);
             }
-            while(curNode.Parent != nullptr);
+            while(curNode.Parent >= 0);
         }
-        path.push_front(curNode);
+        path.push_front(curNode.toNode());
     }
     for(auto it = path.begin(); it != path.end(); it++)
         hppath.push_back(*it);
@@ -629,26 +680,26 @@ void AA_SIPP::makePrimaryPath(Node curNode)
     return;
 }
 
-void AA_SIPP::makeSecondaryPath(Node curNode)
+void AA_SIPP::makeSecondaryPath(SearchNode curNode)
 {
     lppath.clear();
-    if(curNode.Parent != nullptr)
+    if(curNode.Parent >= 0)
     {
         std::vector<Node> lineSegment;
         do
         {
-            calculateLineSegment(lineSegment, *curNode.Parent, curNode);
+            calculateLineSegment(lineSegment, close.getNode(curNode.Parent), curNode);
             lppath.insert(lppath.begin(), ++lineSegment.begin(), lineSegment.end());
-            curNode = *curNode.Parent;
+            curNode = close.getNode(curNode.Parent);
         }
-        while(curNode.Parent != nullptr);
+        while(curNode.Parent >= 0);
         lppath.push_front(*lineSegment.begin());
     }
     else
-        lppath.push_front(curNode);
+        lppath.push_front(curNode.toNode());
 }
 
-void AA_SIPP::calculateLineSegment(std::vector<Node> &line, const Node &start, const Node &goal)
+void AA_SIPP::calculateLineSegment(std::vector<Node> &line, const SearchNode &start, const SearchNode &goal)
 {
     int i1 = start.i;
     int i2 = goal.i;
@@ -7,11 +7,19 @@
 #include "searchresult.h"
 #include "task.h"
 #include "dynamicobstacles.h"
+#include "openlist.h"
+#include "closelist.h"
+#include "heuristic.h"
+#include "conflictchecker.h"
 #include <math.h>
 #include <memory>
 #include <algorithm>
-#include <unordered_map>
 #include <random>
+#include <cfloat>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <sstream>
 #ifdef __linux__
     #include <sys/time.h>
 #else
@@ -25,38 +33,67 @@ public:
     AA_SIPP(const Config &config);
     ~AA_SIPP();
     SearchResult startSearch(Map &map, Task &task, DynamicObstacles &obstacles);
+    //fills the caches of the map (valid moves, landmarks) needed by the agents of the task, after that the search doesn't change the map,
+    //so the searches of several tasks may share it
+    static void prepareMap(Map &map, const Task &task, const Config &config);
+    //the constraints of the dynamic obstacles, they are built once and copied by each thread of the search
+    static std::shared_ptr<const Constraints> buildObstacleLayer(const Map &map, const DynamicObstacles &obstacles);
+    void setObstacleLayer(std::shared_ptr<const Constraints> layer) { obstacleLayer = layer; }//the layer is built by startSearch if it's not set
+    //receives the messages of the search (the agents without a path, the conflicts of the solution), one line without '\n' per call.
+    //They are printed to std::cout if the handler is not set. The workers of the portfolio call it from their own threads.
+    void setMessageHandler(std::function<void(const std::string&)> handler) { this->handler = handler; }
+    //limits the threads that compute the true distance heuristic, 0 means one per CPU core except the one busy with the planning
+    void setHeuristicThreads(unsigned int threads) { heuristicthreads = threads; }
     SearchResult sresult;
 private:
 
-    void addOpen(Node &newNode);
-    Node findMin(int size);
-    bool stopCriterion(const Node &curNode, Node &goalNode);
-    bool testGoal(const Node &curNode, Node &goalNode);
+    void addOpen(const SearchNode &newNode);
+    bool stopCriterion(const SearchNode &curNode, SearchNode &goalNode);
     double getCost(int a_i, int a_j, int b_i, int b_j);
     double getRCost(double headingA, double headingB);
-    double calcHeading(const Node &node, const Node &son);
-    std::list<Node> findSuccessors(const Node curNode, const Map &map);
-    void makePrimaryPath(Node curNode);
-    void makeSecondaryPath(Node curNode);
-    void calculateLineSegment(std::vector<Node> &line, const Node &start, const Node &goal);
+    double calcHeading(const SearchNode &node, const SearchNode &son);
+    void findSuccessors(const SearchNode &curNode, const Map &map);
+    void makePrimaryPath(SearchNode curNode);
+    void makeSecondaryPath(SearchNode curNode);
+    void calculateLineSegment(std::vector<Node> &line, const SearchNode &start, const SearchNode &goal);
     void addConstraints(){}
-    Node resetParent(Node current, Node Parent, const Map &map);
+    SearchNode resetParent(const SearchNode &current, const SearchNode &parent, const Map &map);
     bool findPath(unsigned int numOfCurAgent, const Map &map);
-    std::vector<conflict> CheckConflicts(const Task &task);//bruteforce checker. It splits final(already built) trajectories into sequences of points and checks distances between them
-    void setPriorities(const Task &task);
+    std::vector<conflict> CheckConflicts(const Task &task);//checks the final(already built) trajectories for collisions, see ConflictChecker
+    void setPriorities(const Task &task, int prioritization);
     double getHValue(int i, int j);
+    double getDetour(int k);
     bool changePriorities(int bad_i);
-    unsigned int openSize;
+    unsigned int getSeed();
+    int search(const Map &map, const Task &task, std::shared_ptr<const Constraints> layer, double timelimit);//tries the orderings one after another, returns the number of tries
+    int startPortfolio(const Map &map, const Task &task, std::shared_ptr<const Constraints> layer, double timelimit);//tries several orderings at once in different threads
+    void setVariant(const Task &task, int variant);
+    void message(const std::string &text) const;
     std::list<Node> lppath;
-    std::vector<std::list<Node>> open;
-    std::unordered_multimap<int, Node> close;
+    OpenList open;
+    CloseList close;
+    std::vector<SearchNode> successors;
     std::vector<Node> hppath;
     std::vector<std::vector<int>> priorities;
     std::vector<int> current_priorities;
-    LineOfSight lineofsight;
+    const LineOfSight *lineofsight; //shared footprint of the current agent
+    Heuristic heuristic;
+    const Heuristic *truedistances;      //the tables of this search or of the search that started the portfolio
+    const std::vector<float> *distances; //distances to the goal of the current agent, if the heuristic is computed by Dijkstra
+    const Landmarks *landmarks;          //landmarks for the size of the current agent, if the heuristic uses them
+    std::vector<float> goaldistances;    //distances from the landmarks to the goal of the current agent
+    double detour;                        //how much longer the grid moves can be than a straight line, 1 if the moves are not shortened
+    unsigned int width;
+    std::atomic<bool> *cancelled;        //set when another worker of the portfolio has found a solution
+    int seed;                            //seed of the own generator of the worker, -1 if the orderings are shuffled with rand()
+    std::mt19937 generator;
+    std::vector<Node> moves;
     Agent curagent;
     Constraints *constraints;
+    std::shared_ptr<const Constraints> obstacleLayer;
     std::shared_ptr<const Config> config;
+    std::function<void(const std::string&)> handler;
+    unsigned int heuristicthreads;
 };
 
 #endif // AA_SIPP_H
@@ -0,0 +1,208 @@
+#include "batch.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#ifdef __linux__
+    #include <dirent.h>
+#else
+    #include <windows.h>
+#endif
+
+Batch::Batch()
+{
+    mapName = tasksName = configName = obstaclesName = nullptr;
+    heuristicThreads = 0;
+}
+
+void Batch::setFileNames(const char *tasksName, const char *mapName, const char *configName, const char *obstaclesName)
+{
+    this->mapName = mapName;
+    this->tasksName = tasksName;
+    this->configName = configName;
+    this->obstaclesName = obstaclesName;
+}
+
+bool Batch::getMap()
+{
+    return m_map.getMap(mapName);
+}
+
+bool Batch::getConfig()
+{
+    return m_config.getConfig(configName);
+}
+
+bool Batch::getObstacles()
+{
+    if(obstaclesName)
+        return m_obstacles.getObstacles(obstaclesName);
+    else
+        return false;
+}
+
+bool Batch::listTasks(std::vector<std::string> &names)
+{
+    std::string path(tasksName);
+    std::string logSuffix = std::string(CN_LOG) + ".xml";
+    auto isTask = [&logSuffix](const std::string &name)
+    {
+        if(name.size() < 4 || name.compare(name.size() - 4, 4, ".xml") != 0)
+            return false;
+        return name.size() < logSuffix.size() || name.compare(name.size() - logSuffix.size(), logSuffix.size(), logSuffix) != 0;
+    };
+#ifdef __linux__
+    DIR *dir = opendir(path.c_str());
+    if(dir)
+    {
+        while(dirent *entry = readdir(dir))
+            if(isTask(entry->d_name))
+                names.push_back(path + "/" + entry->d_name);
+        closedir(dir);
+        std::sort(names.begin(), names.end());
+        return true;
+    }
+#else
+    DWORD attributes = GetFileAttributesA(path.c_str());
+    if(attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY))
+    {
+        WIN32_FIND_DATAA entry;
+        HANDLE handle = FindFirstFileA((path + "\\*.xml").c_str(), &entry);
+        if(handle != INVALID_HANDLE_VALUE)
+        {
+            do
+                if(isTask(entry.cFileName))
+                    names.push_back(path + "\\" + entry.cFileName);
+            while(FindNextFileA(handle, &entry));
+            FindClose(handle);
+        }
+        std::sort(names.begin(), names.end());
+        return true;
+    }
+#endif
+    //not a directory, so it's a list of the task files
+    std::ifstream list(path);
+    if(!list)
+    {
+        std::cout<<"Error opening the list of tasks '"<<path<<"'.\n";
+        return false;
+    }
+    std::string line;
+    while(std::getline(list, line))
+    {
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        line.erase(0, line.find_first_not_of(" \t"));
+        if(!line.empty())
+            names.push_back(line);
+    }
+    return true;
+}
+
+bool Batch::getTasks()
+{
+    std::vector<std::string> names;
+    if(!listTasks(names))
+        return false;
+    if(names.empty())
+    {
+        std::cout<<"No task files found in '"<<tasksName<<"'.\n";
+        return false;
+    }
+    jobs.resize(names.size());
+    for(unsigned int k = 0; k < names.size(); k++)
+    {
+        jobs[k].taskName = names[k];
+        jobs[k].loaded = jobs[k].task.getTask(names[k].c_str()) && jobs[k].task.validateTask(m_map);
+        if(!jobs[k].loaded)
+            std::cout<<"Task file '"<<names[k]<<"' is skipped.\n";
+    }
+    return true;
+}
+
+void Batch::saveSearchResultsToLog(const Job &job)
+{
+    if(m_config.loglevel == CN_LOGLVL_NO)
+        return;
+    XmlLogger logger(m_config.loglevel);
+    logger.createLog(job.taskName.c_str());
+    logger.writeToLogInput(job.taskName.c_str(), mapName, configName, obstaclesName);
+    logger.writeToLogSummary(job.sr);
+    if(job.sr.pathfound)
+    {
+        logger.writeToLogMap(m_map, job.sr);
+        logger.writeToLogPath(job.sr, job.task, m_config);
+    }
+    logger.saveLog();
+}
+
+void Batch::solve(Job &job)
+{
+    AA_SIPP search(m_config);
+    search.setObstacleLayer(m_obstacleLayer);
+    search.setHeuristicThreads(heuristicThreads);
+    std::mutex guard;//the workers of the portfolio may report at once
+    search.setMessageHandler([&job, &guard](const std::string &text)
+    {
+        std::lock_guard<std::mutex> lock(guard);
+        job.messages += text + "\n";
+    });
+    job.sr = search.startSearch(m_map, job.task, m_obstacles);
+    saveSearchResultsToLog(job);
+}
+
+void Batch::printRow(const Job &job)
+{
+    std::cout<<job.messages;
+    if(!job.loaded)
+    {
+        std::cout<<job.taskName<<";0;0;0;0;0;0;0;0\n";
+        return;
+    }
+    const SearchResult &sr = job.sr;
+    std::cout<<job.taskName<<";1;"<<bool(sr.agentsSolved/sr.agents)<<";"<<sr.tries<<";"<<sr.runtime<<";"<<sr.agentsSolved<<";"
+             <<sr.agents<<";"<<sr.flowtime<<";"<<sr.makespan<<std::endl;
+}
+
+void Batch::startSearch(int threads)
+{
+    //the searches only read the map, so all its caches are filled before they start. This is shared by all the tasks
+    //and is not a part of their runtimes, so it's reported separately
+    auto begin = std::chrono::steady_clock::now();
+    for(const Job &job : jobs)
+        if(job.loaded)
+            AA_SIPP::prepareMap(m_map, job.task, m_config);
+    m_obstacleLayer = AA_SIPP::buildObstacleLayer(m_map, m_obstacles);
+    std::cout<<"PREPARED "<<std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count()<<"\n";
+
+    std::cout<<"Task;Loaded;Solved;Tries;Runtime;AgentsSolved;Agents;Flowtime;Makespan\n";
+    if(threads <= 0)
+        threads = std::max(int(std::thread::hardware_concurrency()), 1);
+    threads = std::min(threads, int(jobs.size()));
+    //each task keeps one core busy with the planning, the rest of the cores are shared by the heuristic threads of all the tasks
+    int cores = std::max(int(std::thread::hardware_concurrency()), 1);
+    heuristicThreads = std::max(cores/std::max(threads, 1) - 1, 1);
+    //the tasks are taken in order, the rows are printed as soon as all the previous tasks are done
+    std::atomic<unsigned int> next(0);
+    std::vector<bool> done(jobs.size(), false);
+    unsigned int printed(0);
+    std::mutex output;
+    auto work = [&]()
+    {
+        unsigned int k;
+        while((k = next++) < jobs.size())
+        {
+            if(jobs[k].loaded)
+                solve(jobs[k]);
+            std::lock_guard<std::mutex> lock(output);
+            done[k] = true;
+            while(printed < jobs.size() && done[printed])
+                printRow(jobs[printed++]);
+        }
+    };
+    std::vector<std::thread> pool;
+    for(int t = 1; t < threads; t++)
+        pool.emplace_back(work);
+    work();
+    for(std::thread &t : pool)
+        t.join();
+}
@@ -0,0 +1,61 @@
+/* This class solves a set of tasks on the same map with the same config and dynamic obstacles, that are loaded only once.
+ * The tasks are given either by a directory (all its XML files except the logs) or by a text file with one task file per line.
+ * The caches of the map and the constraints of the dynamic obstacles are prepared before the searches start and shared by them,
+ * so the tasks may be solved by several threads. One summary row per task is printed in the order of the tasks,
+ * the logs are written next to the task files as in the single task mode.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "map.h"
+#include "config.h"
+#include "xmlLogger.h"
+#include "searchresult.h"
+#include "aa_sipp.h"
+#include "task.h"
+#include "dynamicobstacles.h"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+
+class Batch
+{
+public:
+    Batch();
+    void setFileNames(const char *tasksName, const char *mapName, const char *configName, const char *obstaclesName);
+    bool getMap();
+    bool getConfig();
+    bool getObstacles();
+    bool getTasks();
+    void startSearch(int threads); //0 means one thread per CPU core
+
+private:
+    struct Job
+    {
+        std::string taskName;
+        Task task;
+        bool loaded;
+        SearchResult sr;
+        std::string messages; //the messages of the search, printed together with the row of the task
+    };
+    bool listTasks(std::vector<std::string> &names);
+    void solve(Job &job);
+    void saveSearchResultsToLog(const Job &job);
+    void printRow(const Job &job);
+
+    Map              m_map;
+    Config           m_config;
+    DynamicObstacles m_obstacles;
+    std::shared_ptr<const Constraints> m_obstacleLayer;
+    std::vector<Job> jobs;
+    unsigned int heuristicThreads; //threads of the true distance heuristic of each task
+    const char*      mapName;
+    const char*      tasksName;
+    const char*      configName;
+    const char*      obstaclesName;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#include "closelist.h"
+
+CloseList::CloseList()
+{
+    stamp = 1;
+    width = 0;
+}
+
+void CloseList::resize(int width, int height)
+{
+    this->width = width;
+    cellHead.assign(width*height, -1);
+    cellStamp.assign(width*height, 0);
+    nodes.clear();
+    nextInCell.clear();
+    stamp = 1;
+}
+
+void CloseList::clear()
+{
+    nodes.clear();
+    nextInCell.clear();
+    stamp++;
+    if(stamp == 0)//stamps have wrapped around, so the old ones can't be trusted anymore
+    {
+        std::fill(cellStamp.begin(), cellStamp.end(), 0);
+        stamp = 1;
+    }
+}
+
+int CloseList::add(const SearchNode &node)
+{
+    int id = nodes.size();
+    int cell = node.i*width + node.j;
+    nodes.push_back(node);
+    nextInCell.push_back(cellStamp[cell] == stamp ? cellHead[cell] : -1);
+    cellHead[cell] = id;
+    cellStamp[cell] = stamp;
+    return id;
+}
+
+int CloseList::first(int i, int j) const
+{
+    int cell = i*width + j;
+    return cellStamp[cell] == stamp ? cellHead[cell] : -1;
+}
@@ -0,0 +1,34 @@
+/* This class implements CLOSE list of AA-SIPP as an arena of expanded nodes.
+ * Nodes are addressed by their indices in the arena, which are used as parent links instead of pointers.
+ * Expanded nodes of each cell are chained, so they can be enumerated without any hashing.
+ * Clearing the list takes O(1): the cell chains are invalidated by stamps rather than by reinitialization.
+ */
+
+#ifndef CLOSELIST_H
+#define CLOSELIST_H
+#include "structs.h"
+#include <vector>
+#include <algorithm>
+
+class CloseList
+{
+public:
+    CloseList();
+    void resize(int width, int height);
+    void clear();
+    int add(const SearchNode &node);
+    const SearchNode& getNode(int id) const { return nodes[id]; }
+    int first(int i, int j) const; //returns the last expanded node of the cell or -1
+    int next(int id) const { return nextInCell[id]; }
+    unsigned int size() const { return nodes.size(); }
+
+private:
+    std::vector<SearchNode> nodes;
+    std::vector<int> nextInCell;
+    std::vector<int> cellHead;
+    std::vector<unsigned int> cellStamp;
+    unsigned int stamp;
+    int width;
+};
+
+#endif // CLOSELIST_H
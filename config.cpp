@@ -11,6 +11,9 @@ Config::Config()
     rescheduling = CN_DEFAULT_RESCHEDULING;
     planforturns = CN_DEFAULT_PLANFORTURNS;
     additionalwait = CN_DEFAULT_ADDITIONALWAIT;
+    heuristic = CN_DEFAULT_HEURISTIC;
+    portfolio = CN_DEFAULT_PORTFOLIO;
+    validationthreads = CN_DEFAULT_VALIDATIONTHREADS;
 }
 
 bool Config::getConfig(const char* fileName)
@@ -227,6 +230,68 @@ bool Config::getConfig(const char* fileName)
         }
     }
 
+    element = algorithm->FirstChildElement(CNS_TAG_HEURISTIC);
+    if (!element)
+    {
+        std::cout << "Warning! No '"<<CNS_TAG_HEURISTIC<<"' element found inside '"<<CNS_TAG_ALGORITHM<<"' section. Its value is set to '"<<CNS_DEFAULT_HEURISTIC<<"'."<<std::endl;
+        heuristic = CN_DEFAULT_HEURISTIC;
+    }
+    else
+    {
+        value = element->GetText();
+        if(value == CNS_HEUR_GEOMETRIC)
+            heuristic = CN_HEUR_GEOMETRIC;
+        else if(value == CNS_HEUR_DIJKSTRA)
+            heuristic = CN_HEUR_DIJKSTRA;
+        else if(value == CNS_HEUR_LANDMARKS)
+            heuristic = CN_HEUR_LANDMARKS;
+        else
+        {
+            std::cout << "Warning! Wrong '"<<CNS_TAG_HEURISTIC<<"' value. It's set to '"<<CNS_DEFAULT_HEURISTIC<<"'."<<std::endl;
+            heuristic = CN_DEFAULT_HEURISTIC;
+        }
+    }
+
+    element = algorithm->FirstChildElement(CNS_TAG_PORTFOLIO);
+    if (!element)
+    {
+        std::cout << "Warning! No '"<<CNS_TAG_PORTFOLIO<<"' element found inside '"<<CNS_TAG_ALGORITHM<<"' section. Its value is set to '"<<CN_DEFAULT_PORTFOLIO<<"'."<<std::endl;
+        portfolio = CN_DEFAULT_PORTFOLIO;
+    }
+    else
+    {
+        value = element->GetText();
+        stream<<value;
+        stream>>portfolio;
+        stream.clear();
+        stream.str("");
+        if(portfolio < 0 || portfolio > 256)
+        {
+            std::cout << "Warning! Wrong value of '"<<CNS_TAG_PORTFOLIO<<"' element. It should belong to the interval [0,256]. Its value is set to '"<<CN_DEFAULT_PORTFOLIO<<"'."<<std::endl;
+            portfolio = CN_DEFAULT_PORTFOLIO;
+        }
+    }
+
+    element = algorithm->FirstChildElement(CNS_TAG_VALIDATIONTHREADS);
+    if (!element)
+    {
+        std::cout << "Warning! No '"<<CNS_TAG_VALIDATIONTHREADS<<"' element found inside '"<<CNS_TAG_ALGORITHM<<"' section. Its value is set to '"<<CN_DEFAULT_VALIDATIONTHREADS<<"'."<<std::endl;
+        validationthreads = CN_DEFAULT_VALIDATIONTHREADS;
+    }
+    else
+    {
+        value = element->GetText();
+        stream<<value;
+        stream>>validationthreads;
+        stream.clear();
+        stream.str("");
+        if(validationthreads < 0 || validationthreads > 256)
+        {
+            std::cout << "Warning! Wrong value of '"<<CNS_TAG_VALIDATIONTHREADS<<"' element. It should belong to the interval [0,256]. Its value is set to '"<<CN_DEFAULT_VALIDATIONTHREADS<<"'."<<std::endl;
+            validationthreads = CN_DEFAULT_VALIDATIONTHREADS;
+        }
+    }
+
     XMLElement *options = root->FirstChildElement(CNS_TAG_OPTIONS);
     if(!options)
     {
@@ -20,6 +20,9 @@ public:
     double timelimit;
     int rescheduling;
     double inflatecollisionintervals;
+    int heuristic;
+    int portfolio;
+    int validationthreads;
     int initialprioritization;
     double startsafeinterval;
     double additionalwait;
@@ -0,0 +1,226 @@
+#include "conflictchecker.h"
+
+ConflictChecker::ConflictChecker(int threads)
+{
+    this->threads = threads > 0 ? threads : std::max(int(std::thread::hardware_concurrency()), 1);
+    cellSize = 1;
+    origin_i = origin_j = 0;
+    rows = columns = 0;
+}
+
+void ConflictChecker::addPiece(int agent, int section, double g1, double g2, double i, double j, double vi, double vj, double size)
+{
+    Piece piece;
+    piece.agent = agent;
+    piece.section = section;
+    piece.g1 = g1;
+    piece.g2 = g2;
+    piece.i = i;
+    piece.j = j;
+    piece.vi = vi;
+    piece.vj = vj;
+    piece.size = size;
+    double end_i(g2 < CN_INFINITY ? i + vi*(g2 - g1) : i), end_j(g2 < CN_INFINITY ? j + vj*(g2 - g1) : j);
+    piece.min_i = std::min(i, end_i) - size;
+    piece.max_i = std::max(i, end_i) + size;
+    piece.min_j = std::min(j, end_j) - size;
+    piece.max_j = std::max(j, end_j) + size;
+    pieces.push_back(piece);
+}
+
+void ConflictChecker::addPieces(int agent, const std::vector<Node> &sections, double size)
+{
+    for(unsigned int s = 1; s < sections.size(); s++)
+    {
+        const Node &a(sections[s - 1]), &b(sections[s]);
+        double duration(b.g - a.g);
+        if(duration <= 0)
+            continue;
+        double vi((b.i - a.i)/duration), vj((b.j - a.j)/duration);
+        //long moves are cut, so the bounding box of each piece covers only a few cells of the grid
+        int parts = std::max(1, int(ceil(sqrt(double((b.i - a.i)*(b.i - a.i) + (b.j - a.j)*(b.j - a.j)))/cellSize)));
+        for(int p = 0; p < parts; p++)
+        {
+            double g1(a.g + duration*p/parts), g2(p + 1 == parts ? b.g : a.g + duration*(p + 1)/parts);
+            addPiece(agent, s - 1, g1, g2, a.i + vi*(g1 - a.g), a.j + vj*(g1 - a.g), vi, vj, size);
+        }
+    }
+    addPiece(agent, sections.size() - 1, sections.back().g, CN_INFINITY, sections.back().i, sections.back().j, 0, 0, size);
+}
+
+int ConflictChecker::getCell(double i, double j) const
+{
+    int row = std::min(std::max(int(floor((i - origin_i)/cellSize)), 0), rows - 1);
+    int column = std::min(std::max(int(floor((j - origin_j)/cellSize)), 0), columns - 1);
+    return row*columns + column;
+}
+
+void ConflictChecker::buildGrid()
+{
+    origin_i = origin_j = CN_INFINITY;
+    double max_i(-CN_INFINITY), max_j(-CN_INFINITY);
+    for(const Piece &p : pieces)
+    {
+        origin_i = std::min(origin_i, p.min_i);
+        origin_j = std::min(origin_j, p.min_j);
+        max_i = std::max(max_i, p.max_i);
+        max_j = std::max(max_j, p.max_j);
+    }
+    rows = int(floor((max_i - origin_i)/cellSize)) + 1;
+    columns = int(floor((max_j - origin_j)/cellSize)) + 1;
+    //counting sort of the (cell, piece) pairs, the pieces of each cell are then ordered by the start time
+    auto forEachCell = [this](const Piece &p, std::function<void(int)> f)
+    {
+        int first(getCell(p.min_i, p.min_j)), last(getCell(p.max_i, p.max_j));
+        for(int row = first/columns; row <= last/columns; row++)
+            for(int column = first%columns; column <= last%columns; column++)
+                f(row*columns + column);
+    };
+    cellBegin.assign(rows*columns + 1, 0);
+    for(const Piece &p : pieces)
+        forEachCell(p, [this](int c){ cellBegin[c + 1]++; });
+    for(unsigned int c = 1; c < cellBegin.size(); c++)
+        cellBegin[c] += cellBegin[c - 1];
+    cellPieces.resize(cellBegin.back());
+    std::vector<unsigned int> cursor(cellBegin.begin(), cellBegin.end() - 1);
+    for(unsigned int n = 0; n < pieces.size(); n++)
+        forEachCell(pieces[n], [this, &cursor, n](int c){ cellPieces[cursor[c]++] = n; });
+    parallel(rows*columns, [this](int begin, int end, int)
+    {
+        for(int c = begin; c < end; c++)
+            std::sort(cellPieces.begin() + cellBegin[c], cellPieces.begin() + cellBegin[c + 1], [this](int a, int b)
+                { return pieces[a].g1 < pieces[b].g1 || (pieces[a].g1 == pieces[b].g1 && a < b); });
+    });
+}
+
+void ConflictChecker::parallel(int count, const std::function<void(int, int, int)> &job) const
+{
+    const int block = 1024;
+    int workers = std::min(threads, (count + block - 1)/block);
+    if(workers <= 1)
+    {
+        job(0, count, 0);
+        return;
+    }
+    std::atomic<int> next(0);
+    auto work = [&](int thread)
+    {
+        int begin;
+        while((begin = block*next++) < count)
+            job(begin, std::min(begin + block, count), thread);
+    };
+    std::vector<std::thread> pool;
+    for(int t = 1; t < workers; t++)
+        pool.emplace_back(work, t);
+    work(0);
+    for(std::thread &t : pool)
+        t.join();
+}
+
+bool ConflictChecker::getCollision(const Piece &a, const Piece &b, double &begin, double &end) const
+{
+    double t0(std::max(a.g1, b.g1)), t1(std::min(a.g2, b.g2));
+    if(t0 >= t1)
+        return false;
+    //the difference of the positions is D + V*tau, tau in [0, t1 - t0], it's shorter than r inside the roots of a quadratic
+    double r(a.size + b.size - CN_EPSILON);
+    double Di(a.i + a.vi*(t0 - a.g1) - b.i - b.vi*(t0 - b.g1)), Dj(a.j + a.vj*(t0 - a.g1) - b.j - b.vj*(t0 - b.g1));
+    double Vi(a.vi - b.vi), Vj(a.vj - b.vj);
+    double qa(Vi*Vi + Vj*Vj), qb(Di*Vi + Dj*Vj), qc(Di*Di + Dj*Dj - r*r);
+    if(qa < CN_EPSILON)
+    {
+        if(qc >= 0)
+            return false;
+        begin = t0;
+        end = t1;
+        return true;
+    }
+    double dscr(qb*qb - qa*qc);
+    if(dscr <= 0)
+        return false;
+    begin = std::max(t0, t0 + (-qb - sqrt(dscr))/qa);
+    end = std::min(t1, t0 + (-qb + sqrt(dscr))/qa);
+    return begin < end;
+}
+
+void ConflictChecker::checkCell(int cell, std::vector<Collision> &collisions) const
+{
+    for(unsigned int x = cellBegin[cell]; x < cellBegin[cell + 1]; x++)
+    {
+        const Piece &a = pieces[cellPieces[x]];
+        for(unsigned int y = x + 1; y < cellBegin[cell + 1]; y++)
+        {
+            const Piece &b = pieces[cellPieces[y]];
+            if(b.g1 > a.g2)//the pieces are ordered by g1, so the rest ones start later as well
+                break;
+            if(a.agent == b.agent || a.max_i < b.min_i || b.max_i < a.min_i || a.max_j < b.min_j || b.max_j < a.min_j)
+                continue;
+            //the boxes may share several cells, the pair is checked only in the one that holds the corner of their intersection
+            if(getCell(std::max(a.min_i, b.min_i), std::max(a.min_j, b.min_j)) != cell)
+                continue;
+            Collision c;
+            if(getCollision(a, b, c.begin, c.end))
+            {
+                bool swap(a.agent > b.agent);
+                c.agent1 = swap ? b.agent : a.agent;
+                c.agent2 = swap ? a.agent : b.agent;
+                c.sec1 = swap ? b.section : a.section;
+                c.sec2 = swap ? a.section : b.section;
+                collisions.push_back(c);
+            }
+        }
+    }
+}
+
+std::vector<conflict> ConflictChecker::check(const SearchResult &result, const Task &task)
+{
+    std::vector<conflict> conflicts;
+    pieces.clear();
+    double maxsize(0);
+    for(unsigned int k = 0; k < result.agents; k++)
+        if(result.pathInfo[k].pathfound && !result.pathInfo[k].sections.empty())
+            maxsize = std::max(maxsize, task.getAgent(k).size);
+    cellSize = std::max(1.0, 2*maxsize);
+    for(unsigned int k = 0; k < result.agents; k++)
+        if(result.pathInfo[k].pathfound && !result.pathInfo[k].sections.empty())
+            addPieces(k, result.pathInfo[k].sections, task.getAgent(k).size);
+    if(pieces.empty())
+        return conflicts;
+    buildGrid();
+
+    //each thread collects the collisions of its cells, the order they are found in is lost by sorting
+    std::vector<std::vector<Collision>> found(threads);
+    parallel(rows*columns, [this, &found](int begin, int end, int thread)
+    {
+        for(int c = begin; c < end; c++)
+            checkCell(c, found[thread]);
+    });
+    std::vector<Collision> collisions;
+    for(const std::vector<Collision> &f : found)
+        collisions.insert(collisions.end(), f.begin(), f.end());
+    std::sort(collisions.begin(), collisions.end());
+
+    //the collisions of the consecutive pieces of the same pair of agents are merged
+    for(unsigned int k = 0; k < collisions.size(); k++)
+    {
+        const Collision &c = collisions[k];
+        if(k > 0 && c.agent1 == collisions[k - 1].agent1 && c.agent2 == collisions[k - 1].agent2 && c.begin <= collisions[k - 1].end + CN_EPSILON)
+        {
+            collisions[k].end = std::max(c.end, collisions[k - 1].end);
+            continue;
+        }
+        conflict conf;
+        conf.agent1 = c.agent1;
+        conf.agent2 = c.agent2;
+        conf.sec1 = c.sec1;
+        conf.sec2 = c.sec2;
+        conf.g = c.begin;
+        const std::vector<Node> &sections = result.pathInfo[c.agent2].sections;
+        const Node &a(sections[c.sec2]), &b(c.sec2 + 1 < int(sections.size()) ? sections[c.sec2 + 1] : sections[c.sec2]);
+        double part(b.g > a.g ? (c.begin - a.g)/(b.g - a.g) : 0);
+        conf.i = a.i + (b.i - a.i)*part;
+        conf.j = a.j + (b.j - a.j)*part;
+        conflicts.push_back(conf);
+    }
+    return conflicts;
+}
@@ -0,0 +1,73 @@
+/* This class validates the solution found by AA_SIPP: it finds the moments when two agents come closer than the sum of their sizes.
+ * The trajectories are cut into pieces not longer than a cell of a uniform grid. The broad phase puts the pieces into the cells
+ * covered by their bounding boxes (inflated by the size of the agent) and sweeps the pieces of each cell in the order of time.
+ * The narrow phase solves the distance between two linearly moving disks exactly, so no collision is missed between samples.
+ * The agents stay at their goals after they reach them, so the last piece of each trajectory never ends.
+ * The cells are checked by several threads, the result doesn't depend on their number.
+ */
+
+#ifndef CONFLICTCHECKER_H
+#define CONFLICTCHECKER_H
+#include "gl_const.h"
+#include "structs.h"
+#include "searchresult.h"
+#include "task.h"
+#include <vector>
+#include <math.h>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <atomic>
+
+class ConflictChecker
+{
+public:
+    ConflictChecker(int threads = 1); //0 means one thread per CPU core
+    //returns one conflict per pair of agents and continuous period of collision, sorted by the agents and time.
+    //'g', 'i' and 'j' tell when the collision starts and where the second agent is at that moment
+    std::vector<conflict> check(const SearchResult &result, const Task &task);
+
+private:
+    struct Piece
+    {
+        int agent;
+        int section;         //index of the section of the path the piece belongs to
+        double g1, g2;       //g2 is CN_INFINITY for the agent staying at its goal
+        double i, j;         //position at g1
+        double vi, vj;
+        double size;
+        double min_i, min_j, max_i, max_j;
+    };
+    struct Collision
+    {
+        int agent1, agent2;
+        int sec1, sec2;
+        double begin, end;
+        bool operator < (const Collision &c) const
+        {
+            if(agent1 != c.agent1 || agent2 != c.agent2)
+                return agent1 != c.agent1 ? agent1 < c.agent1 : agent2 < c.agent2;
+            if(begin != c.begin || end != c.end)
+                return begin != c.begin ? begin < c.begin : end < c.end;
+            return sec1 != c.sec1 ? sec1 < c.sec1 : sec2 < c.sec2;
+        }
+    };
+    void addPieces(int agent, const std::vector<Node> &sections, double size);
+    void addPiece(int agent, int section, double g1, double g2, double i, double j, double vi, double vj, double size);
+    void buildGrid();
+    int getCell(double i, double j) const;
+    bool getCollision(const Piece &a, const Piece &b, double &begin, double &end) const;
+    void checkCell(int cell, std::vector<Collision> &collisions) const;
+    //calls job(begin, end, thread) for the blocks of [0, count) in all the threads
+    void parallel(int count, const std::function<void(int, int, int)> &job) const;
+
+    int threads;
+    double cellSize;
+    double origin_i, origin_j;
+    int rows, columns;
+    std::vector<Piece> pieces;
+    std::vector<int> cellPieces;          //pieces of cell c are cellPieces[cellBegin[c]..cellBegin[c+1]), ordered by g1
+    std::vector<unsigned int> cellBegin;
+};
+
+#endif // CONFLICTCHECKER_H
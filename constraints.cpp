@@ -2,23 +2,15 @@
 
 Constraints::Constraints(int width, int height)
 {
-    safe_intervals.resize(height);
-    for(int i = 0; i < height; i++)
-    {
-        safe_intervals[i].resize(width);
-        for(int j = 0; j < width; j++)
-        {
-            safe_intervals[i][j].resize(0);
-            safe_intervals[i][j].push_back({0,CN_INFINITY});
-        }
-    }
-    constraints.resize(height);
-    for(int i = 0; i < height; i++)
-    {
-        constraints[i].resize(width);
-        for(int j = 0; j < width; j++)
-            constraints[i][j].resize(0);
-    }
+    this->width = width;
+    this->height = height;
+    intervals_size = -1;
+    interval_info.resize(width*height);
+    intervals_garbage = 0;
+    cell_runs.resize(width*height);
+    sections_garbage = 0;
+    query_stamp = 0;
+    los = nullptr;
 }
 
 bool sort_function(std::pair<double, double> a, std::pair<double, double> b)
@@ -37,31 +29,154 @@ double Constraints::minDist(Point A, Point C, Point D)
         return fabs((C.i - D.i)*A.j + (D.j - C.j)*A.i + (C.j*D.i - D.j*C.i))/sqrt(pow(C.i - D.i, 2) + pow(C.j - D.j, 2));
 }
 
-void Constraints::resetSafeIntervals(int width, int height)
+void Constraints::resetSafeIntervals()
+{
+    interval_info.clear();
+    intervals_store.clear();
+    intervals_garbage = 0;
+}
+
+void Constraints::invalidateSafeIntervals(const std::vector<std::pair<int, int>> &cells)
+{
+    if(intervals_size < 0)
+        return;
+    const LineOfSight &los = LineOfSight::get(intervals_size);//safe intervals of a cell depend on the constraints of all the cells covered by the agent's body
+    for(auto cell: cells)
+        for(auto c: los.getCells(cell.first, cell.second))
+            if(c.first >= 0 && c.first < height && c.second >= 0 && c.second < width && interval_info.get(c.first*width + c.second).valid)
+            {
+                cellIntervals &info = interval_info.at(c.first*width + c.second);
+                info.valid = false;
+                intervals_garbage += info.count;
+            }
+}
+
+void Constraints::addSection(int i, int j, section &sec)
+{
+    if(sec.id < 0)
+    {
+        sec.id = added_sections.size();
+        added_sections.push_back(sec);
+        removed_sections.push_back(false);
+        section_stamps.push_back(0);
+    }
+    pending.push_back({i*width + j, sec.id});
+    placements.push_back({i*width + j, sec.id});
+}
+
+void Constraints::collectSections(int i, int j, double begin, double end, std::vector<section> &sections)
+{
+    const cellRun &run = cell_runs.get(i*width + j);
+    for(unsigned int k = run.begin; k < run.finite; k++)
+        if(cell_sections[k].g1 <= end && section_stamps[cell_sections[k].id] != query_stamp)
+        {
+            section_stamps[cell_sections[k].id] = query_stamp;
+            sections.push_back(added_sections[cell_sections[k].id]);
+        }
+    //all the sections before the first one that reaches 'begin' have already ended
+    auto it = std::lower_bound(cell_sections.begin() + run.finite, cell_sections.begin() + run.end, begin,
+                               [](const cellSection &s, double t){ return s.reach < t; });
+    for(; it != cell_sections.begin() + run.end && it->g1 <= end; it++)
+        if(it->g2 >= begin && section_stamps[it->id] != query_stamp)
+        {
+            section_stamps[it->id] = query_stamp;
+            sections.push_back(added_sections[it->id]);
+        }
+}
+
+void Constraints::compact()
 {
-    safe_intervals.resize(height);
-    for(int i = 0; i < height; i++)
+    if(!pending.empty() || !dirty_cells.empty())
+    {
+        for(auto p: pending)
+            dirty_cells.push_back(p.first);
+        std::sort(dirty_cells.begin(), dirty_cells.end());
+        dirty_cells.erase(std::unique(dirty_cells.begin(), dirty_cells.end()), dirty_cells.end());
+        std::stable_sort(pending.begin(), pending.end(),
+                         [](const std::pair<int, int> &a, const std::pair<int, int> &b){ return a.first < b.first; });
+        unsigned int p = 0;
+        for(int c: dirty_cells)//the changed cells get their new runs at the end of the storage, the old runs become garbage
+        {
+            cellRun run = cell_runs.get(c);
+            unsigned int first = cell_sections.size();
+            for(unsigned int k = run.begin; k < run.end; k++)
+                if(!removed_sections[cell_sections[k].id])
+                {
+                    cellSection sec = cell_sections[k];
+                    cell_sections.push_back(sec);
+                }
+            sections_garbage += run.end - run.begin;
+            bool added = false;
+            for(; p < pending.size() && pending[p].first == c; p++)
+                if(!removed_sections[pending[p].second])
+                {
+                    const section &sec = added_sections[pending[p].second];
+                    cell_sections.push_back({sec.g1, sec.g2, sec.g2, sec.id});
+                    added = true;
+                }
+            if(added)//sections with infinite g2 go first in the order of addition, the rest ones are sorted by g1, then by the order of addition
+                std::sort(cell_sections.begin() + first, cell_sections.end(), [](const cellSection &a, const cellSection &b)
+                    { return a.g2 >= CN_INFINITY ? (b.g2 < CN_INFINITY || a.id < b.id) : (b.g2 < CN_INFINITY && (a.g1 < b.g1 || (a.g1 == b.g1 && a.id < b.id))); });
+            run.begin = first;
+            run.end = cell_sections.size();
+            run.finite = first;
+            while(run.finite < run.end && cell_sections[run.finite].g2 >= CN_INFINITY)
+                run.finite++;
+            for(unsigned int k = run.finite; k < run.end; k++)
+                cell_sections[k].reach = (k > run.finite) ? std::max(cell_sections[k - 1].reach, cell_sections[k].g2) : cell_sections[k].g2;
+            cell_runs.at(c) = run;
+        }
+        pending.clear();
+        dirty_cells.clear();
+    }
+    if(sections_garbage > cell_sections.size()/2)
     {
-        safe_intervals[i].resize(width);
-        for(int j = 0; j < width; j++)
+        std::vector<cellSection> store;
+        store.reserve(cell_sections.size() - sections_garbage);
+        for(cellRun &run: cell_runs.allocated())
         {
-            safe_intervals[i][j].resize(0);
-            safe_intervals[i][j].push_back({0,CN_INFINITY});
+            unsigned int first = store.size();
+            store.insert(store.end(), cell_sections.begin() + run.begin, cell_sections.begin() + run.end);
+            run.finite = first + run.finite - run.begin;
+            run.begin = first;
+            run.end = store.size();
         }
+        cell_sections.swap(store);
+        sections_garbage = 0;
+    }
+    if(intervals_garbage > intervals_store.size()/2)
+    {
+        std::vector<SafeInterval> store;
+        for(cellIntervals &info: interval_info.allocated())
+        {
+            if(!info.valid)
+            {
+                info.count = 0;
+                continue;
+            }
+            store.insert(store.end(), intervals_store.begin() + info.begin, intervals_store.begin() + info.begin + info.count);
+            info.begin = store.size() - info.count;
+        }
+        intervals_store.swap(store);
+        intervals_garbage = 0;
     }
 }
 
 void Constraints::updateCellSafeIntervals(std::pair<int, int> cell)
 {
-    if(safe_intervals[cell.first][cell.second].size() > 1)
+    if(agentsize != intervals_size)
+    {
+        resetSafeIntervals();
+        intervals_size = agentsize;
+    }
+    if(interval_info.get(cell.first*width + cell.second).valid)
         return;
-    LineOfSight los(agentsize);
-    std::vector<std::pair<int, int>> cells = los.getCells(cell.first, cell.second);
+    cell_intervals = {SafeInterval(0, CN_INFINITY)};
+    std::vector<std::pair<int, int>> cells = los->getCells(cell.first, cell.second);
     std::vector<section> secs;
-    for(int k = 0; k < cells.size(); k++)
-        for(int l = 0; l < constraints[cells[k].first][cells[k].second].size(); l++)
-            if(std::find(secs.begin(), secs.end(), constraints[cells[k].first][cells[k].second][l]) == secs.end())
-                secs.push_back(constraints[cells[k].first][cells[k].second][l]);
+    query_stamp++;
+    for(unsigned int k = 0; k < cells.size(); k++)
+        collectSections(cells[k].first, cells[k].second, -CN_INFINITY, CN_INFINITY, secs);
 
     for(int k = 0; k < secs.size(); k++)
     {
@@ -120,81 +235,84 @@ void Constraints::updateCellSafeIntervals(std::pair<int, int> cell)
                 interval.end = sec.g1 + ha/sec.mspeed + size/sec.mspeed;
             }
         }
-        for(unsigned int j = 0; j < safe_intervals[i2][j2].size(); j++)
+        for(unsigned int j = 0; j < cell_intervals.size(); j++)
         {
-            if(safe_intervals[i2][j2][j].begin < interval.begin + CN_EPSILON && safe_intervals[i2][j2][j].end + CN_EPSILON > interval.begin)
+            if(cell_intervals[j].begin < interval.begin + CN_EPSILON && cell_intervals[j].end + CN_EPSILON > interval.begin)
             {
-                if(fabs(safe_intervals[i2][j2][j].begin - interval.begin) < CN_EPSILON)
+                if(fabs(cell_intervals[j].begin - interval.begin) < CN_EPSILON)
                 {
-                    safe_intervals[i2][j2].insert(safe_intervals[i2][j2].begin() + j, SafeInterval(safe_intervals[i2][j2][j].begin,safe_intervals[i2][j2][j].begin));
+                    cell_intervals.insert(cell_intervals.begin() + j, SafeInterval(cell_intervals[j].begin,cell_intervals[j].begin));
                     j++;
-                    if(safe_intervals[i2][j2][j].end < interval.end)
-                        safe_intervals[i2][j2].erase(safe_intervals[i2][j2].begin() + j);
+                    if(cell_intervals[j].end < interval.end)
+                        cell_intervals.erase(cell_intervals.begin() + j);
                     else
-                        safe_intervals[i2][j2][j].begin = interval.end;
+                        cell_intervals[j].begin = interval.end;
                 }
-                else if(safe_intervals[i2][j2][j].end < interval.end)
-                    safe_intervals[i2][j2][j].end = interval.begin;
+                else if(cell_intervals[j].end < interval.end)
+                    cell_intervals[j].end = interval.begin;
                 else
                 {
                     std::pair<double,double> new1, new2;
-                    new1.first = safe_intervals[i2][j2][j].begin;
+                    new1.first = cell_intervals[j].begin;
                     new1.second = interval.begin;
                     new2.first = interval.end;
-                    new2.second = safe_intervals[i2][j2][j].end;
-                    safe_intervals[i2][j2].erase(safe_intervals[i2][j2].begin() + j);
+                    new2.second = cell_intervals[j].end;
+                    cell_intervals.erase(cell_intervals.begin() + j);
                     if(new2.first < CN_INFINITY)
-                        safe_intervals[i2][j2].insert(safe_intervals[i2][j2].begin() + j, SafeInterval(new2.first, new2.second));
-                    safe_intervals[i2][j2].insert(safe_intervals[i2][j2].begin() + j, SafeInterval(new1.first, new1.second));
+                        cell_intervals.insert(cell_intervals.begin() + j, SafeInterval(new2.first, new2.second));
+                    cell_intervals.insert(cell_intervals.begin() + j, SafeInterval(new1.first, new1.second));
                 }
             }
-            else if(safe_intervals[i2][j2][j].begin > interval.begin - CN_EPSILON && safe_intervals[i2][j2][j].begin < interval.end)
+            else if(cell_intervals[j].begin > interval.begin - CN_EPSILON && cell_intervals[j].begin < interval.end)
             {
-                if(fabs(safe_intervals[i2][j2][j].begin - interval.begin) < CN_EPSILON)
+                if(fabs(cell_intervals[j].begin - interval.begin) < CN_EPSILON)
                 {
-                    safe_intervals[i2][j2].insert(safe_intervals[i2][j2].begin() + j, SafeInterval(safe_intervals[i2][j2][j].begin,safe_intervals[i2][j2][j].begin));
+                    cell_intervals.insert(cell_intervals.begin() + j, SafeInterval(cell_intervals[j].begin,cell_intervals[j].begin));
                     j++;
                 }
-                if(safe_intervals[i2][j2][j].end < interval.end)
+                if(cell_intervals[j].end < interval.end)
                 {
-                    safe_intervals[i2][j2].erase(safe_intervals[i2][j2].begin() + j);
+                    cell_intervals.erase(cell_intervals.begin() + j);
                 }
                 else
                 {
-                    safe_intervals[i2][j2][j].begin = interval.end;
+                    cell_intervals[j].begin = interval.end;
                 }
             }
         }
-        for(unsigned int j = 0; j < safe_intervals[i2][j2].size(); j++)
-            safe_intervals[i2][j2][j].id = j;
+        for(unsigned int j = 0; j < cell_intervals.size(); j++)
+            cell_intervals[j].id = j;
     }
+    interval_info.at(cell.first*width + cell.second) = {static_cast<unsigned int>(intervals_store.size()), static_cast<unsigned int>(cell_intervals.size()), true};
+    intervals_store.insert(intervals_store.end(), cell_intervals.begin(), cell_intervals.end());
 }
 
-std::vector<SafeInterval> Constraints::getSafeIntervals(Node curNode, const std::unordered_multimap<int, Node> &close, int w)
+std::vector<SafeInterval> Constraints::getSafeIntervals(const SearchNode &curNode, const SearchNode &parent, const CloseList &close)
 {
     std::vector<SafeInterval> intervals(0);
-    auto range = close.equal_range(curNode.i*w + curNode.j);
-    for(unsigned int i = 0; i < safe_intervals[curNode.i][curNode.j].size(); i++)
-        if(safe_intervals[curNode.i][curNode.j][i].end >= curNode.g
-                && safe_intervals[curNode.i][curNode.j][i].begin <= (curNode.Parent->interval.end + curNode.g - curNode.Parent->g))
+    const cellIntervals &info = interval_info.get(curNode.i*width + curNode.j);
+    const SafeInterval *cell = intervals_store.data() + info.begin;
+    for(unsigned int i = 0; i < info.count; i++)
+        if(cell[i].end >= curNode.g && cell[i].begin <= (parent.interval_end + curNode.g - parent.g))
         {
             bool has = false;
-            for(auto it = range.first; it != range.second; it++)
-                if(it->second.interval.begin == safe_intervals[curNode.i][curNode.j][i].begin)
-                if((it->second.g + tweight*fabs(curNode.heading - it->second.heading)/(180*rspeed)) - curNode.g < CN_EPSILON)//take into account turning cost
+            for(int c = close.first(curNode.i, curNode.j); c >= 0; c = close.next(c))
+                if(close.getNode(c).interval_id == cell[i].id)
+                if((close.getNode(c).g + tweight*fabs(curNode.heading - close.getNode(c).heading)/(180*rspeed)) - curNode.g < CN_EPSILON)//take into account turning cost
                 {
                     has = true;
                     break;
                 }
             if(!has)
-                intervals.push_back(safe_intervals[curNode.i][curNode.j][i]);
+                intervals.push_back(cell[i]);
         }
     return intervals;
 }
 
 std::vector<SafeInterval> Constraints::getSafeIntervals(Node curNode)
 {
-    return safe_intervals[curNode.i][curNode.j];
+    const cellIntervals &info = interval_info.get(curNode.i*width + curNode.j);
+    return std::vector<SafeInterval>(intervals_store.begin() + info.begin, intervals_store.begin() + info.begin + info.count);
 }
 
 void Constraints::addStartConstraint(int i, int j, int size, std::vector<std::pair<int, int> > cells, double agentsize)
@@ -202,44 +320,87 @@ void Constraints::addStartConstraint(int i, int j, int size, std::vector<std::pa
     section sec(i, j, i, j, 0, size);
     sec.size = agentsize;
     for(auto cell: cells)
-        constraints[cell.first][cell.second].insert(constraints[cell.first][cell.second].begin(),sec);
+        addSection(cell.first, cell.second, sec);
+    invalidateSafeIntervals(cells);
     return;
 }
 
 void Constraints::removeStartConstraint(std::vector<std::pair<int, int> > cells, int start_i, int start_j)
 {
+    auto isStart = [&](int id){ const section &sec = added_sections[id];
+                                return !removed_sections[id] && sec.i1 == start_i && sec.j1 == start_j && sec.g1 < CN_EPSILON; };
+    unsigned int first = removals.size();
     for(auto cell: cells)
-        for(size_t k = 0; k < constraints[cell.first][cell.second].size(); k++)
-            if(constraints[cell.first][cell.second][k].i1 == start_i && constraints[cell.first][cell.second][k].j1 == start_j && constraints[cell.first][cell.second][k].g1 < CN_EPSILON)
+    {
+        const cellRun &run = cell_runs.get(cell.first*width + cell.second);
+        for(unsigned int k = run.begin; k < run.end; k++)
+            if(isStart(cell_sections[k].id))
             {
-                constraints[cell.first][cell.second].erase(constraints[cell.first][cell.second].begin() + k);
-                k--;
+                removals.push_back({cell.first*width + cell.second, cell_sections[k].id});
+                dirty_cells.push_back(cell.first*width + cell.second);
             }
+    }
+    for(auto p: pending)//the start constraints that are not merged yet, compact() skips them once they are removed
+        if(isStart(p.second) && std::find(cells.begin(), cells.end(), std::make_pair(p.first/width, p.first%width)) != cells.end())
+            removals.push_back(p);
+    for(unsigned int k = first; k < removals.size(); k++)//a section covers several cells, so it's marked after all of them are found
+        removed_sections[removals[k].second] = true;
+    invalidateSafeIntervals(cells);
     return;
 }
 
+void Constraints::rollback(const constraintsCheckpoint &checkpoint)
+{
+    std::vector<int> touched;
+    for(unsigned int k = checkpoint.sections; k < added_sections.size(); k++)
+        removed_sections[k] = true;
+    for(unsigned int k = checkpoint.placements; k < placements.size(); k++)
+        touched.push_back(placements[k].first);
+    placements.resize(checkpoint.placements);
+    pending.erase(std::remove_if(pending.begin(), pending.end(), [&checkpoint](const std::pair<int, int> &p)
+        { return p.second >= int(checkpoint.sections); }), pending.end());
+    dirty_cells.insert(dirty_cells.end(), touched.begin(), touched.end());
+    compact();//the dropped sections leave the storage here, so their ids can be reused
+    added_sections.resize(checkpoint.sections);
+    removed_sections.resize(checkpoint.sections);
+    section_stamps.resize(checkpoint.sections);
+    for(unsigned int k = checkpoint.removals; k < removals.size(); k++)
+        if(removals[k].second < int(checkpoint.sections))
+        {
+            removed_sections[removals[k].second] = false;
+            pending.push_back(removals[k]);
+            touched.push_back(removals[k].first);
+        }
+    removals.resize(checkpoint.removals);
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    std::vector<std::pair<int, int>> cells;
+    for(int c: touched)
+        cells.push_back({c/width, c%width});
+    invalidateSafeIntervals(cells);
+}
+
 void Constraints::addConstraints(const std::vector<Node> &sections, double size, double mspeed, const Map &map)
 {
     std::vector<std::pair<int,int>> cells;
-    LineOfSight los(size);
+    const LineOfSight &los = LineOfSight::get(size);
     section sec(sections.back(), sections.back());
     sec.g2 = CN_INFINITY;
     sec.size = size;
     sec.mspeed = mspeed;
-    cells = los.getCellsCrossedByLine(sec.i1, sec.j1, sec.i2, sec.j2, map);
+    los.getCellsCrossedByLine(sec.i1, sec.j1, sec.i2, sec.j2, map, cells);
     for(auto cell: cells)
-        constraints[cell.first][cell.second].push_back(sec);
-    if(sec.g1 == 0)
-        for(auto cell: cells)
-            safe_intervals[cell.first][cell.second].clear();
+        addSection(cell.first, cell.second, sec);
+    invalidateSafeIntervals(cells);
     for(unsigned int a = 1; a < sections.size(); a++)
     {
-        cells = los.getCellsCrossedByLine(sections[a-1].i, sections[a-1].j, sections[a].i, sections[a].j, map);
+        los.getCellsCrossedByLine(sections[a-1].i, sections[a-1].j, sections[a].i, sections[a].j, map, cells);
         sec = section(sections[a-1], sections[a]);
         sec.size = size;
         sec.mspeed = mspeed;
         for(unsigned int i = 0; i < cells.size(); i++)
-            constraints[cells[i].first][cells[i].second].push_back(sec);
+            addSection(cells[i].first, cells[i].second, sec);
+        invalidateSafeIntervals(cells);
         /*if(a+1 == sections.size())
             updateSafeIntervals(cells,sec,true);
         else
@@ -247,63 +408,50 @@ void Constraints::addConstraints(const std::vector<Node> &sections, double size,
     }
 }
 
-std::vector<SafeInterval> Constraints::findIntervals(Node curNode, std::vector<double> &EAT, const std::unordered_multimap<int, Node> &close, const Map &map)
+std::vector<SafeInterval> Constraints::findIntervals(const SearchNode &curNode, const SearchNode &parent, std::vector<double> &EAT, const CloseList &close, const Map &map)
 {
-    std::vector<SafeInterval> curNodeIntervals = getSafeIntervals(curNode, close, map.width);
+    std::vector<SafeInterval> curNodeIntervals = getSafeIntervals(curNode, parent, close);
     if(curNodeIntervals.empty())
         return curNodeIntervals;
     EAT.clear();
-    LineOfSight los(agentsize);
-    std::vector<std::pair<int,int>> cells = los.getCellsCrossedByLine(curNode.i, curNode.j, curNode.Parent->i, curNode.Parent->j, map);
+    los->getCellsCrossedByLine(curNode.i, curNode.j, parent.i, parent.j, map, line_cells);
     std::vector<section> sections(0);
-    section sec;
-    for(unsigned int i = 0; i < cells.size(); i++)
-        for(unsigned int j = 0; j < constraints[cells[i].first][cells[i].second].size(); j++)
-        {
-            sec = constraints[cells[i].first][cells[i].second][j];
-            if(sec.g2 < curNode.Parent->g || sec.g1 > (curNode.Parent->interval.end + curNode.g - curNode.Parent->g))
-                continue;
-            if(std::find(sections.begin(), sections.end(), sec) == sections.end())
-                sections.push_back(sec);
-        }
-    auto range = close.equal_range(curNode.i*map.width + curNode.j);
+    query_stamp++;
+    for(unsigned int i = 0; i < line_cells.size(); i++)
+        collectSections(line_cells[i].first, line_cells[i].second, parent.g, parent.interval_end + curNode.g - parent.g, sections);
+
+    double duration(curNode.g - parent.g);
+    buffer.clear();
+    for(unsigned int k = 0; k < sections.size(); k++)
+        buffer.add(sections[k]);
+    buffer.getUnsafeWindows(curNode, parent, agentsize + inflateintervals);
+    std::vector<std::pair<double, double>> windows;
+    for(unsigned int k = 0; k < buffer.size(); k++)
+        if(buffer.begin(k) < buffer.end(k))
+            windows.push_back({buffer.begin(k), buffer.end(k)});
+    std::sort(windows.begin(), windows.end());
 
     for(unsigned int i=0; i<curNodeIntervals.size(); i++)
     {
         SafeInterval cur_interval(curNodeIntervals[i]);
         if(cur_interval.begin < curNode.g)
             cur_interval.begin = curNode.g;
-        double startTimeA = curNode.Parent->g;
-        if(cur_interval.begin > startTimeA + curNode.g - curNode.Parent->g)
-            startTimeA = cur_interval.begin - curNode.g + curNode.Parent->g;
-        unsigned int j = 0;
-        bool goal_collision;
-        while(j < sections.size())
+        double startTimeA = std::max(parent.g, cur_interval.begin - duration);
+        for(unsigned int k = 0; k < windows.size() && windows[k].first < startTimeA; k++)
+            if(windows[k].second > startTimeA)
+                startTimeA = windows[k].second;//the earliest departure after this window, the next ones start later
+        cur_interval.begin = startTimeA + duration;
+        if(cur_interval.begin > cur_interval.end || startTimeA > parent.interval_end)
         {
-            goal_collision = false;
-
-            if(hasCollision(curNode, startTimeA, sections[j], goal_collision))
-            {
-                double offset = 1.0;
-                startTimeA += offset;
-                cur_interval.begin += offset;
-                j = 0;//start to check all constraints again, because time has changed
-                if(goal_collision || cur_interval.begin > cur_interval.end || startTimeA > curNode.Parent->interval.end)
-                {
-                    curNodeIntervals.erase(curNodeIntervals.begin() + i);
-                    i--;
-                    break;
-                }
-            }
-            else
-                j++;
+            curNodeIntervals.erase(curNodeIntervals.begin() + i);
+            i--;
         }
-        if(j == sections.size())
+        else
         {
             bool has = false;
-            for(auto rit = range.first; rit != range.second; rit++)
-                if(rit->second.interval.begin == curNodeIntervals[i].begin)
-                if((rit->second.g + tweight*fabs(curNode.heading - rit->second.heading)/(180*rspeed) - cur_interval.begin) < CN_EPSILON)//take into account turning cost
+            for(int c = close.first(curNode.i, curNode.j); c >= 0; c = close.next(c))
+                if(close.getNode(c).interval_id == curNodeIntervals[i].id)
+                if((close.getNode(c).g + tweight*fabs(curNode.heading - close.getNode(c).heading)/(180*rspeed) - cur_interval.begin) < CN_EPSILON)//take into account turning cost
                 {
                     has = true;
                     curNodeIntervals.erase(curNodeIntervals.begin()+i);
@@ -316,53 +464,3 @@ std::vector<SafeInterval> Constraints::findIntervals(Node curNode, std::vector<d
     }
     return curNodeIntervals;
 }
-
-bool Constraints::hasCollision(const Node &curNode, double startTimeA, const section &constraint, bool &goal_collision)
-{
-    double endTimeA(startTimeA + curNode.g - curNode.Parent->g), startTimeB(constraint.g1), endTimeB(constraint.g2);
-    if(startTimeA > endTimeB || startTimeB > endTimeA)
-        return false;
-    Vector2D A(curNode.Parent->i,curNode.Parent->j);
-    Vector2D VA((curNode.i - curNode.Parent->i)/(curNode.g - curNode.Parent->g), (curNode.j - curNode.Parent->j)/(curNode.g - curNode.Parent->g));
-    Vector2D B(constraint.i1, constraint.j1);
-    Vector2D VB((constraint.i2 - constraint.i1)/(constraint.g2 - constraint.g1), (constraint.j2 - constraint.j1)/(constraint.g2 - constraint.g1));
-    if(startTimeB > startTimeA)
-    {
-      // Move A to the same time instant as B
-      A += VA*(startTimeB-startTimeA);
-      startTimeA=startTimeB;
-    }
-    else if(startTimeB < startTimeA)
-    {
-      B += VB*(startTimeA - startTimeB);
-      startTimeB = startTimeA;
-    }
-    double r(constraint.size + agentsize + inflateintervals); //combined radius
-    Vector2D w(B - A);
-    double c(w*w - r*r);
-    if(c < 0)
-    {
-        if(constraint.g2 == CN_INFINITY)
-            goal_collision = true;
-        return true;
-    } // Agents are currently colliding
-
-    // Use the quadratic formula to detect nearest collision (if any)
-    Vector2D v(VA - VB);
-    double a(v*v);
-    double b(w*v);
-
-    double dscr(b*b - a*c);
-    if(dscr <= 0)
-        return false;
-
-    double ctime = (b - sqrt(dscr))/a;
-    if(ctime > -CN_EPSILON && ctime < std::min(endTimeB,endTimeA) - startTimeA + CN_EPSILON)
-    {
-        if(constraint.g2 == CN_INFINITY)
-            goal_collision = true;
-        return true;
-    }
-    else
-        return false;
-}
@@ -2,13 +2,70 @@
 #define CONSTRAINTS_H
 
 #include <vector>
-#include <unordered_map>
 #include "gl_const.h"
 #include "structs.h"
 #include <algorithm>
 #include <iostream>
 #include <lineofsight.h>
 #include "map.h"
+#include "closelist.h"
+#include "sectionbuffer.h"
+
+struct cellSection
+{
+    double g1;
+    double g2;
+    double reach; //the latest g2 among this one and all the previous sections of the cell with finite g2
+    int id;
+};
+
+struct cellRun
+{
+    unsigned int begin;  //sections of the cell are cell_sections[begin..end)
+    unsigned int finite; //the first section of the cell with finite g2, these ones are sorted by g1
+    unsigned int end;
+};
+
+struct cellIntervals
+{
+    unsigned int begin; //safe intervals of the cell are intervals_store[begin..begin+count)
+    unsigned int count;
+    bool valid;         //the intervals are up to date with the constraints and 'intervals_size'
+};
+
+//Values of the cells kept in pages of consecutive cells. A page is allocated when one of its cells is set for the first time,
+//so the cells of the untouched pages cost no memory and are read as the default value.
+template<typename T>
+class CellTable
+{
+public:
+    void resize(int cells) { pages.assign((cells + PAGE - 1)/PAGE, -1); values.clear(); }
+    void clear() { std::fill(pages.begin(), pages.end(), -1); values.clear(); }
+    const T &get(int cell) const { int page = pages[cell/PAGE]; return page < 0 ? empty : values[page + cell%PAGE]; }
+    T &at(int cell)
+    {
+        int &page = pages[cell/PAGE];
+        if(page < 0)
+        {
+            page = values.size();
+            values.resize(values.size() + PAGE, empty);
+        }
+        return values[page + cell%PAGE];
+    }
+    std::vector<T> &allocated() { return values; }//values of all the cells of the allocated pages, in no particular order
+private:
+    static const int PAGE = 64;
+    std::vector<int> pages;
+    std::vector<T> values;
+    T empty{};
+};
+
+struct constraintsCheckpoint
+{
+    unsigned int sections;   //number of the sections added before the checkpoint
+    unsigned int placements; //number of the (cell, section) pairs added before the checkpoint
+    unsigned int removals;   //number of the start constraints removed before the checkpoint
+};
 
 class Constraints
 {
@@ -16,27 +73,52 @@ public:
     Constraints(int width, int height);
     ~Constraints(){}
     void updateCellSafeIntervals(std::pair<int, int> cell);
-    std::vector<SafeInterval> getSafeIntervals(Node curNode, const std::unordered_multimap<int, Node> &close, int w);
+    std::vector<SafeInterval> getSafeIntervals(const SearchNode &curNode, const SearchNode &parent, const CloseList &close);
     std::vector<SafeInterval> getSafeIntervals(Node curNode);
     void addConstraints(const std::vector<Node> &sections, double size, double mspeed, const Map &map);
-    std::vector<SafeInterval> findIntervals(Node curNode, std::vector<double> &EAT, const std::unordered_multimap<int, Node> &close, const Map &map);
-    SafeInterval getSafeInterval(int i, int j, int n) {return safe_intervals[i][j][n];}
-    void resetSafeIntervals(int width, int height);
+    std::vector<SafeInterval> findIntervals(const SearchNode &curNode, const SearchNode &parent, std::vector<double> &EAT, const CloseList &close, const Map &map);
+    SafeInterval getSafeInterval(int i, int j, int n) {return intervals_store[interval_info.get(i*width + j).begin + n];}
+    void resetSafeIntervals();
     void addStartConstraint(int i, int j, int size, std::vector<std::pair<int, int>> cells, double agentsize = 0.5);
     void removeStartConstraint(std::vector<std::pair<int, int>> cells, int start_i, int start_j);
-    void setSize(double size) {agentsize = size;}
+    void setSize(double size) {agentsize = size; los = &LineOfSight::get(size);}
     void setParams(double size, double mspeed, double rspeed, double tweight, double inflateintervals)
-    { agentsize = size; this->mspeed = mspeed; this->rspeed = rspeed; this->tweight = tweight; this->inflateintervals = inflateintervals; }
+    { agentsize = size; los = &LineOfSight::get(size); this->mspeed = mspeed; this->rspeed = rspeed; this->tweight = tweight; this->inflateintervals = inflateintervals; }
     double minDist(Point A, Point C, Point D);
+    void compact(); //merges the added and removed constraints of the changed cells into the flat storage, must be called before the search
+    constraintsCheckpoint getCheckpoint() const
+    { return {static_cast<unsigned int>(added_sections.size()), static_cast<unsigned int>(placements.size()), static_cast<unsigned int>(removals.size())}; }
+    void rollback(const constraintsCheckpoint &checkpoint); //drops the constraints added and restores the ones removed after the checkpoint
 
 
 private:
-    bool hasCollision(const Node &curNode, double startTimeA, const section &constraint, bool &goal_collision);
-    std::vector<std::vector<std::vector<section>>> constraints;
-    std::vector<std::vector<std::vector<SafeInterval>>> safe_intervals;
+    void invalidateSafeIntervals(const std::vector<std::pair<int, int>> &cells);
+    void addSection(int i, int j, section &sec);
+    void collectSections(int i, int j, double begin, double end, std::vector<section> &sections);
+    std::vector<section> added_sections;       //all the sections ever added, indexed by their ids
+    std::vector<bool> removed_sections;
+    std::vector<std::pair<int, int>> placements; //(cell, section id) pairs in the order of addition, rollback takes the cells of the dropped sections from here
+    std::vector<std::pair<int, int>> removals;   //(cell, section id) pairs removed by removeStartConstraint, in the order of removal
+    std::vector<std::pair<int, int>> pending;    //(cell, section id) pairs that are not merged into 'cell_sections' yet
+    std::vector<int> dirty_cells;                //cells whose runs hold removed sections
+    std::vector<cellSection> cell_sections;      //runs of sections of the cells, a merged cell gets a new run at the end
+    CellTable<cellRun> cell_runs;
+    unsigned int sections_garbage;               //total length of the abandoned runs
+    std::vector<unsigned int> section_stamps;    //the last query each section was collected by
+    unsigned int query_stamp;
+    std::vector<SafeInterval> intervals_store;   //safe intervals of all the cells, the outdated ones are dropped by compact()
+    CellTable<cellIntervals> interval_info;
+    unsigned int intervals_garbage;
+    std::vector<SafeInterval> cell_intervals;
+    std::vector<std::pair<int, int>> line_cells; //cells swept by the move checked in findIntervals
+    SectionBuffer buffer;
+    double intervals_size;                       //size of the agent the valid safe intervals were computed for
+    int width;
+    int height;
     double rspeed;
     double mspeed;
     double agentsize;
+    const LineOfSight *los; //footprint of the agent of 'agentsize'
     double tweight;
     double inflateintervals;
 
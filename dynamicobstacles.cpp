@@ -65,18 +65,24 @@ bool DynamicObstacles::getObstacles(const char *fileName)
             node.g += sec->DoubleAttribute(CNS_TAG_ATTR_DURATION);
             obs.sections.push_back(node);
         }
-        for(size_t i = 1; i < obs.sections.size(); i++)
-            if(obs.sections[i-1].i != obs.sections[i].i || obs.sections[i-1].j != obs.sections[i].j)
-            {
-                double dist = sqrt(pow(obs.sections[i-1].i - obs.sections[i].i, 2) + pow(obs.sections[i-1].j - obs.sections[i].j, 2));
-                obs.mspeed = dist/(obs.sections[i].g - obs.sections[i-1].g);
-                break;
-            }
-        obstacles.push_back(obs);
+        addObstacle(obs);
     }
     return true;
 }
 
+void DynamicObstacles::addObstacle(const obstacle &obs)
+{
+    obstacles.push_back(obs);
+    obstacle &added = obstacles.back();
+    for(size_t i = 1; i < added.sections.size(); i++)
+        if(added.sections[i-1].i != added.sections[i].i || added.sections[i-1].j != added.sections[i].j)
+        {
+            double dist = sqrt(pow(added.sections[i-1].i - added.sections[i].i, 2) + pow(added.sections[i-1].j - added.sections[i].j, 2));
+            added.mspeed = dist/(added.sections[i].g - added.sections[i-1].g);
+            break;
+        }
+}
+
 std::vector<Node> DynamicObstacles::getSections(int num) const
 {
     if(num >= 0 && num < obstacles.size())
@@ -14,6 +14,8 @@ class DynamicObstacles
 public:
     DynamicObstacles();
     bool getObstacles(const char* fileName);
+    //the sections are the positions of the obstacle and the moments it reaches them, its speed is taken from the first move
+    void addObstacle(const obstacle &obs);
     std::vector<Node> getSections(int num) const;
     double getSize(int num) const;
     double getMSpeed(int num) const;
@@ -29,6 +29,10 @@
 #define CN_DEFAULT_ADDITIONALWAIT           0
 #define CN_DEFAULT_STARTSAFEINTERVAL        0
 #define CN_DEFAULT_INFLATEINTERVALS          0
+#define CN_DEFAULT_HEURISTIC                CN_HEUR_GEOMETRIC
+#define CNS_DEFAULT_HEURISTIC               CNS_HEUR_GEOMETRIC
+#define CN_DEFAULT_PORTFOLIO                1
+#define CN_DEFAULT_VALIDATIONTHREADS        0
 
 #define CN_HEADING_WHATEVER                 -1
 #define CNS_HEADING_WHATEVER                "whatever"
@@ -62,6 +66,23 @@
 #define CNS_RE_RULED     "rulebased"
 #define CNS_RE_RANDOM    "random"
 
+//heuristic
+#define CN_HEUR_GEOMETRIC   1
+#define CN_HEUR_DIJKSTRA    2
+#define CN_HEUR_LANDMARKS   3
+
+#define CNS_HEUR_GEOMETRIC  "geometric"
+#define CNS_HEUR_DIJKSTRA   "dijkstra"
+#define CNS_HEUR_LANDMARKS  "landmarks"
+
+//landmarks
+#define CN_NUMBER_OF_LANDMARKS  8
+#define CN_LANDMARKS_MAGIC      "AASIPPLM"
+#define CN_LANDMARKS_VERSION    1
+
+//portfolio
+#define CN_CANCEL_CHECK_PERIOD  256 //expansions between the checks whether another worker has already found a solution
+
 /*
  * XML file tags ---------------------------------------------------------------
  */
@@ -87,6 +108,9 @@
     #define CNS_TAG_PLANFORTURNS            "planforturns"
     #define CNS_TAG_ADDITIONALWAIT          "waitbeforemove"
     #define CNS_TAG_INFLATEINTERVALS        "inflatecollisionintervals"
+    #define CNS_TAG_HEURISTIC               "heuristic"
+    #define CNS_TAG_PORTFOLIO               "portfolio"
+    #define CNS_TAG_VALIDATIONTHREADS       "validationthreads"
     #define CNS_TAG_OPTIONS                 "options"
     #define CNS_TAG_LOGLVL                  "loglevel"
     #define CNS_TAG_LOGPATH                 "logpath"
@@ -0,0 +1,73 @@
+#include "heuristic.h"
+
+Heuristic::Heuristic()
+{
+    map = nullptr;
+    connectedness = 0;
+    next = 0;
+    stopped = false;
+}
+
+Heuristic::~Heuristic()
+{
+    stop();
+}
+
+void Heuristic::start(const Map &map, const Task &task, const std::vector<int> &order, int connectedness, unsigned int threads)
+{
+    stop();
+    this->map = &map;
+    this->connectedness = connectedness;
+    tables.clear();
+    queue.clear();
+    agentTables.assign(task.getNumberOfAgents(), -1);
+    for(int k : order)
+    {
+        Agent agent = task.getAgent(k);
+        for(unsigned int t = 0; t < tables.size(); t++)
+            if(tables[t]->goal_i == agent.goal_i && tables[t]->goal_j == agent.goal_j && fabs(tables[t]->size - agent.size) < CN_EPSILON)
+                agentTables[k] = t;
+        if(agentTables[k] >= 0)
+            continue;
+        agentTables[k] = tables.size();
+        queue.push_back(tables.size());
+        tables.emplace_back(new Table);
+        tables.back()->goal_i = agent.goal_i;
+        tables.back()->goal_j = agent.goal_j;
+        tables.back()->size = agent.size;
+        tables.back()->ready = tables.back()->done.get_future().share();
+    }
+    next = 0;
+    stopped = false;
+    //the planning itself keeps one core busy
+    if(threads == 0)
+        threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    for(unsigned int t = 0; t < std::min<unsigned int>(threads, queue.size()); t++)
+        workers.emplace_back(&Heuristic::work, this);
+}
+
+void Heuristic::work()
+{
+    unsigned int n;
+    while(!stopped && (n = next++) < queue.size())
+    {
+        Table &table = *tables[queue[n]];
+        map->computeDistances(table.goal_i, table.goal_j, connectedness, LineOfSight::get(table.size), table.distances);
+        table.done.set_value();
+    }
+}
+
+const std::vector<float>& Heuristic::get(int agent) const
+{
+    const Table &table = *tables[agentTables[agent]];
+    table.ready.wait();
+    return table.distances;
+}
+
+void Heuristic::stop()
+{
+    stopped = true;
+    for(std::thread &worker : workers)
+        worker.join();
+    workers.clear();
+}
@@ -0,0 +1,51 @@
+/* This class keeps the tables of the true distances to the goals of the agents, used by AA_SIPP as the heuristic.
+ * The tables are computed by backward Dijkstra searches on the static map (see 'computeDistances' of Map) in the background
+ * threads, while the agents are being planned, in the order they are going to be planned. The agents that share the goal
+ * and the size share the table as well. Once computed, the tables are kept for all the rescheduling tries.
+ */
+
+#ifndef HEURISTIC_H
+#define HEURISTIC_H
+#include "map.h"
+#include "task.h"
+#include <vector>
+#include <thread>
+#include <future>
+#include <atomic>
+#include <memory>
+
+class Heuristic
+{
+public:
+    Heuristic();
+    ~Heuristic();
+    //starts computing the tables of all the agents of the task, the agents are taken in the given order.
+    //At most 'threads' threads are used, 0 means one per CPU core except the one busy with the planning
+    void start(const Map &map, const Task &task, const std::vector<int> &order, int connectedness, unsigned int threads = 0);
+    //returns the distances from all the cells to the goal of the agent, waits until the table is ready
+    const std::vector<float>& get(int agent) const;
+    //stops the threads, the tables that are not computed yet are dropped
+    void stop();
+
+private:
+    struct Table
+    {
+        int goal_i, goal_j;
+        double size;
+        std::vector<float> distances;
+        std::promise<void> done;
+        std::shared_future<void> ready;
+    };
+    void work();
+
+    const Map *map;
+    int connectedness;
+    std::vector<std::unique_ptr<Table>> tables;
+    std::vector<int> agentTables;     //index of the table of each agent
+    std::vector<int> queue;           //tables in the order they are needed
+    std::atomic<unsigned int> next;   //the first table of the queue no thread has taken yet
+    std::atomic<bool> stopped;
+    std::vector<std::thread> workers;
+};
+
+#endif // HEURISTIC_H
@@ -1,9 +1,13 @@
 /* (c) 2017. Andreychuk A.
  * This class implements line-of-sight function for a variable size of agent.
  * It also has a method for checking cell's traversability.
- * For its work is needed the size of agent and a map container that has 'cellIsObstacle' and 'cellOnGrid' methods.
+ * For its work is needed the size of agent and a map container that has 'cellIsObstacle', 'cellOnGrid', 'rowHasObstacle' and 'columnHasObstacle' methods.
+ * The last two test whole runs of cells at once, so the band swept by the agent is checked run by run instead of cell by cell.
+ * Traversability is checked by comparing the clearance of the cell (see 'getClearance' of Map) with the size of the body.
  * If it is not possible to give the permission to access the grid, the one can use 'getCellsCrossedByLine' method.
  * It doesn't use grid and returns a set of all cells(as pairs of coordinates) that are crossed by an agent moving along a line.
+ * Footprints are the same for all agents of the same size, so 'get' returns a shared instance that is built only once per size.
+ * The cells swept by a move depend only on its displacement, so they are built once per displacement and then just translated.
  */
 
 #ifndef LINEOFSIGHT_H
@@ -13,6 +17,11 @@
 #define CN_OBSTACLE 1
 
 #include <vector>
+#include <deque>
+#include <mutex>
+#include <list>
+#include <memory>
+#include <unordered_map>
 #include <math.h>
 #include <algorithm>
 
@@ -21,18 +30,7 @@ class LineOfSight
 public:
     LineOfSight(double agentSize = 0.5)
     {
-        this->agentSize = agentSize;
-        int add_x, add_y, num = agentSize + 0.5 - CN_EPSILON;
-        for(int x = -num; x <= +num; x++)
-            for(int y = -num; y <= +num; y++)
-            {
-                add_x = x != 0 ? 1 : 0;
-                add_y = y != 0 ? 1 : 0;
-                if((pow(2*abs(x) - add_x, 2) + pow(2*abs(y) - add_y, 2)) < pow(2*agentSize, 2))
-                    cells.push_back({x, y});
-            }
-        if(cells.empty())
-            cells.push_back({0,0});
+        setSize(agentSize);
     }
 
     void setSize(double agentSize)
@@ -50,60 +48,208 @@ public:
             }
         if(cells.empty())
             cells.push_back({0,0});
+        bodyBound = pow(2*agentSize, 2);
+        halfWidths.assign(num + 1, -1);
+        for(auto cell:cells)
+            halfWidths[std::abs(cell.first)] = std::max(halfWidths[std::abs(cell.first)], std::abs(cell.second));
+        while(halfWidths.back() < 0)
+            halfWidths.pop_back();
+        movePatterns.clear();
+        for(int di = -movesReach; di <= movesReach; di++)
+            for(int dj = -movesReach; dj <= movesReach; dj++)
+                movePatterns.push_back(buildPattern(di, dj));
+        std::lock_guard<std::mutex> lock(cacheGuard);
+        cache.clear();
+        cacheIndex.clear();
+    }
+
+    static const LineOfSight& get(double agentSize)
+    {
+        static std::deque<LineOfSight> registry; //deque keeps the references valid while it grows
+        static std::mutex guard;
+        std::lock_guard<std::mutex> lock(guard);
+        for(const LineOfSight &los : registry)
+            if(fabs(los.agentSize - agentSize) < CN_EPSILON)
+                return los;
+        registry.emplace_back(agentSize);
+        return registry.back();
     }
 
+    double getSize() const { return agentSize; }
+
     template <class T>
-    std::vector<std::pair<int, int>> getCellsCrossedByLine(int x1, int y1, int x2, int y2, const T &map)
+    std::vector<std::pair<int, int>> getCellsCrossedByLine(int x1, int y1, int x2, int y2, const T &map) const
     {
-        std::vector<std::pair<int, int>> lineCells(0);
-        if(x1 == x2 && y1 == y2)
+        std::vector<std::pair<int, int>> lineCells;
+        getCellsCrossedByLine(x1, y1, x2, y2, map, lineCells);
+        return lineCells;
+    }
+
+    //The same, but writes the cells into the given buffer. The cells depend only on the displacement, so they are
+    //taken from the cached pattern of the move (see 'getPattern'), translated to the start and clipped by the grid.
+    template <class T>
+    void getCellsCrossedByLine(int x1, int y1, int x2, int y2, const T &map, std::vector<std::pair<int, int>> &lineCells) const
+    {
+        std::shared_ptr<const Pattern> holder;
+        const Pattern &pattern = getPattern(x2 - x1, y2 - y1, holder);
+        lineCells.clear();
+        for(auto cell:pattern.cells)
+            if(map.CellOnGrid(x1 + cell.first, y1 + cell.second))
+                lineCells.push_back({x1 + cell.first, y1 + cell.second});
+    }
+    //returns all cells that are affected by agent during moving along a line
+
+    template <class T>
+    bool checkTraversability(int x, int y, const T &map) const
+    {
+        //the body covers exactly the cells that are closer than bodyBound, so there must be no obstacles among them
+        if(!map.CellOnGrid(x, y))
+            return false;
+        int clearance = map.getClearance(x, y);
+        return clearance > 0 && clearance >= bodyBound;
+    }
+    //checks traversability of all cells affected by agent's body
+
+    template <class T>
+    bool checkLine(int x1, int y1, int x2, int y2, const T &map) const
+    {
+        //if(!checkTraversability(x1, y1) || !checkTraversability(x2, y2)) //additional check of start and goal traversability,
+        //    return false;                                                //it can be removed if they are already checked
+
+        int delta_x = std::abs(x1 - x2);
+        int delta_y = std::abs(y1 - y2);
+        //all the checked cells are within 'reach' cells from the start along both axes, if there are no obstacles that close the line is clear
+        long long reach = std::max(delta_x, delta_y) + int(2*agentSize) + 3;
+        if(map.getClearance(x1, y1) > 2*(2*reach - 1)*(2*reach - 1))
+            return true;
+        std::shared_ptr<const Pattern> holder;
+        const Pattern &pattern = getPattern(x2 - x1, y2 - y1, holder);
+        for(const Run &run : pattern.runs)
+            if(pattern.rows)
+            {
+                if(run.clipped ? clippedRowHasObstacle(x1 + run.line, y1 + run.from, y1 + run.to, map)
+                               : map.RowHasObstacle(x1 + run.line, y1 + run.from, y1 + run.to))
+                    return false;
+            }
+            else
+            {
+                if(run.clipped ? clippedColumnHasObstacle(y1 + run.line, x1 + run.from, x1 + run.to, map)
+                               : map.ColumnHasObstacle(y1 + run.line, x1 + run.from, x1 + run.to))
+                    return false;
+            }
+        return true;
+    }
+    //checks line-of-sight between a line
+    std::vector<std::pair<int, int>> getCells(int i, int j) const
+    {
+        std::vector<std::pair<int, int>> cells;
+        for(unsigned int k=0; k<this->cells.size(); k++)
+            cells.push_back({i+this->cells[k].first,j+this->cells[k].second});
+        return cells;
+    }
+private:
+    struct Run
+    {
+        int line, from, to; //cells (line, from..to) if the pattern has rows, (from..to, line) otherwise
+        bool clipped;       //the run lies beyond the ends of the line, its cells out of the grid are skipped instead of being obstacles
+    };
+    //everything swept by the body moving from (0, 0) to (di, dj): the cells returned by getCellsCrossedByLine
+    //and the runs of cells tested by checkLine
+    struct Pattern
+    {
+        std::vector<std::pair<int, int>> cells;
+        std::vector<Run> runs;
+        bool rows;
+    };
+
+    //The patterns of the moves of the grid (up to 3 cells along each axis) are built with the footprint and never change.
+    //The longer ones (any-angle mode) are built on demand and the most recently used of them are kept, 'holder' keeps
+    //such a pattern alive while the caller uses it, even if other threads evict it from the cache.
+    const Pattern& getPattern(int di, int dj, std::shared_ptr<const Pattern> &holder) const
+    {
+        if(std::abs(di) <= movesReach && std::abs(dj) <= movesReach)
+            return movePatterns[(di + movesReach)*(2*movesReach + 1) + dj + movesReach];
+        long long key = (static_cast<long long>(di) << 32) | static_cast<unsigned int>(dj);
+        if(findCached(key, holder))
+            return *holder;
+        //the pattern is built without the lock, so the other threads don't wait for it
+        std::shared_ptr<const Pattern> built = std::make_shared<const Pattern>(buildPattern(di, dj));
+        std::lock_guard<std::mutex> lock(cacheGuard);
+        if(findCachedLocked(key, holder))//another thread has built it meanwhile
+            return *holder;
+        holder = built;
+        cache.push_front({key, holder});
+        cacheIndex[key] = cache.begin();
+        if(cache.size() > cacheSize)
         {
-            for(auto cell:cells)
-                lineCells.push_back({x1+cell.first, y1+cell.second});
-            return lineCells;
+            cacheIndex.erase(cache.back().first);
+            cache.pop_back();
         }
+        return *holder;
+    }
+
+    bool findCached(long long key, std::shared_ptr<const Pattern> &holder) const
+    {
+        std::lock_guard<std::mutex> lock(cacheGuard);
+        return findCachedLocked(key, holder);
+    }
+
+    bool findCachedLocked(long long key, std::shared_ptr<const Pattern> &holder) const
+    {
+        auto found = cacheIndex.find(key);
+        if(found == cacheIndex.end())
+            return false;
+        cache.splice(cache.begin(), cache, found->second);
+        holder = found->second->second;
+        return true;
+    }
+
+    Pattern buildPattern(int di, int dj) const
+    {
+        Pattern pattern;
+        buildCells(0, 0, di, dj, pattern.cells);
+        pattern.rows = std::abs(di) > std::abs(dj);
+        if(di != 0 || dj != 0)
+            buildRuns(0, 0, di, dj, pattern.runs);
+        return pattern;
+    }
+
+    //The line is walked along its major axis and each step adds at most three runs of cells across it (the band swept by the body
+    //and the rows of the bodies at both ends), so the runs are merged on the fly and every cell is written once, without searching for duplicates.
+    void buildCells(int x1, int y1, int x2, int y2, std::vector<std::pair<int, int>> &lineCells) const
+    {
         int delta_x = std::abs(x1 - x2);
         int delta_y = std::abs(y1 - y2);
-        if((delta_x >= delta_y && x1 > x2) || (delta_y > delta_x && y1 > y2))
+        bool steep = delta_y > delta_x; //the line is walked along y, so x and y swap their roles below
+        if(steep)
+        {
+            std::swap(x1, y1);
+            std::swap(x2, y2);
+            std::swap(delta_x, delta_y);
+        }
+        if(x1 > x2)
         {
             std::swap(x1, x2);
             std::swap(y1, y2);
         }
-        int step_x = (x1 < x2 ? 1 : -1);
+        int radius = halfWidths.size() - 1;
         int step_y = (y1 < y2 ? 1 : -1);
-        int error = 0, x = x1, y = y1;
-        int k, num;
-        std::pair<int, int> add;
-        int gap = agentSize*sqrt(pow(delta_x, 2) + pow(delta_y, 2)) + double(delta_x + delta_y)/2 - CN_EPSILON;
-
-        if(delta_x >= delta_y)
+        int error = 0, y = y1, extraCheck = 0, gap = 0;
+        if(delta_x > 0)
         {
-            int extraCheck = agentSize*delta_y/sqrt(pow(delta_x, 2) + pow(delta_y, 2)) + 0.5 - CN_EPSILON;
-            for(int n = 1; n <= extraCheck; n++)
+            gap = agentSize*sqrt(pow(delta_x, 2) + pow(delta_y, 2)) + double(delta_x + delta_y)/2 - CN_EPSILON;
+            extraCheck = agentSize*delta_y/sqrt(pow(delta_x, 2) + pow(delta_y, 2)) + 0.5 - CN_EPSILON;
+        }
+        int reach = std::max(extraCheck, radius);
+        std::pair<int, int> runs[3];
+        for(int x = x1 - reach; x <= x2 + reach; x++)
+        {
+            int n = 0, num;
+            if(delta_x > 0 && x >= x1 && x <= x2)
             {
-                error += delta_y;
-                num = (gap - error)/delta_x;
-                for(k = 1; k <= num; k++)
-                    lineCells.push_back({x1 - n*step_x, y1 + k*step_y});
-                for(k = 1; k <= num; k++)
-                    lineCells.push_back({x2 + n*step_x, y2 - k*step_y});
-            }
-            error = 0;
-            for(x = x1; x != x2 + step_x; x+=step_x)
-            {
-                lineCells.push_back({x, y});
-                if(x < x2 - extraCheck)
-                {
-                    num = (gap + error)/delta_x;
-                    for(k = 1; k <= num; k++)
-                        lineCells.push_back({x, y + k*step_y});
-                }
-                if(x > x1 + extraCheck)
-                {
-                    num = (gap - error)/delta_x;
-                    for(k = 1; k <= num; k++)
-                        lineCells.push_back({x, y - k*step_y});
-                }
+                int plus = (x < x2 - extraCheck) ? std::max((gap + error)/delta_x, 0) : 0;
+                int minus = (x > x1 + extraCheck) ? std::max((gap - error)/delta_x, 0) : 0;
+                runs[n++] = (step_y > 0) ? std::make_pair(y - minus, y + plus) : std::make_pair(y - plus, y + minus);
                 error += delta_y;
                 if((error<<1) > delta_x)
                 {
@@ -111,79 +257,38 @@ public:
                     error -= delta_x;
                 }
             }
-        }
-        else
-        {
-            int extraCheck = agentSize*delta_x/sqrt(pow(delta_x, 2) + pow(delta_y, 2)) + 0.5 - CN_EPSILON;
-            for(int n = 1; n <= extraCheck; n++)
+            else if(x < x1 && x1 - x <= extraCheck)
             {
-                error += delta_x;
-                num = (gap - error)/delta_y;
-                for(k = 1; k <= num; k++)
-                    lineCells.push_back({x1 + k*step_x, y1 - n*step_y});
-                for(k = 1; k <= num; k++)
-                    lineCells.push_back({x2 - k*step_x, y2 + n*step_y});
+                num = (gap - (x1 - x)*delta_y)/delta_x;
+                if(num > 0)
+                    runs[n++] = (step_y > 0) ? std::make_pair(y1 + 1, y1 + num) : std::make_pair(y1 - num, y1 - 1);
             }
-            error = 0;
-            for(y = y1; y != y2 + step_y; y += step_y)
+            else if(x > x2 && x - x2 <= extraCheck)
             {
-                lineCells.push_back({x, y});
-                if(y < y2 - extraCheck)
-                {
-                    num = (gap + error)/delta_y;
-                    for(k = 1; k <= num; k++)
-                        lineCells.push_back({x + k*step_x, y});
-                }
-                if(y > y1 + extraCheck)
+                num = (gap - (x - x2)*delta_y)/delta_x;
+                if(num > 0)
+                    runs[n++] = (step_y > 0) ? std::make_pair(y2 - num, y2 - 1) : std::make_pair(y2 + 1, y2 + num);
+            }
+            if(std::abs(x - x1) <= radius)
+                runs[n++] = {y1 - halfWidths[std::abs(x - x1)], y1 + halfWidths[std::abs(x - x1)]};
+            if(std::abs(x - x2) <= radius)
+                runs[n++] = {y2 - halfWidths[std::abs(x - x2)], y2 + halfWidths[std::abs(x - x2)]};
+            if(n == 0)
+                continue;
+            std::sort(runs, runs + n);
+            int next = runs[0].first; //the first cell of the row that is not written yet
+            for(int k = 0; k < n; k++)
+                for(int c = std::max(runs[k].first, next); c <= runs[k].second; c++)
                 {
-                    num = (gap - error)/delta_y;
-                    for(k = 1; k <= num; k++)
-                        lineCells.push_back({x - k*step_x, y});
+                    lineCells.push_back(steep ? std::make_pair(c, x) : std::make_pair(x, c));
+                    next = c + 1;
                 }
-                error += delta_x;
-                if((error<<1) > delta_y)
-                {
-                    x += step_x;
-                    error -= delta_y;
-                }
-            }
-        }
-        for(k = 0; k < cells.size(); k++)
-        {
-            add = {x1 + cells[k].first, y1 + cells[k].second};
-            if(std::find(lineCells.begin(), lineCells.end(), add) == lineCells.end())
-                lineCells.push_back(add);
-            add = {x2 + cells[k].first, y2 + cells[k].second};
-            if(std::find(lineCells.begin(), lineCells.end(), add) == lineCells.end())
-                lineCells.push_back(add);
         }
-
-        for(auto it = lineCells.begin(); it != lineCells.end(); it++)
-            if(!map.CellOnGrid(it->first, it->second))
-            {
-                lineCells.erase(it);
-                it = lineCells.begin();
-            }
-        return lineCells;
     }
-    //returns all cells that are affected by agent during moving along a line
-
-    template <class T>
-    bool checkTraversability(int x, int y, const T &map)
-    {
-        for(int k = 0; k < cells.size(); k++)
-            if(!map.CellOnGrid(x + cells[k].first, y + cells[k].second) || map.CellIsObstacle(x + cells[k].first, y + cells[k].second))
-                return false;
-        return true;
-    }
-    //checks traversability of all cells affected by agent's body
 
-    template <class T>
-    bool checkLine(int x1, int y1, int x2, int y2, const T &map)
+    //the band of cells checked by checkLine, which is a bit narrower than the one of getCellsCrossedByLine and doesn't include the ends
+    void buildRuns(int x1, int y1, int x2, int y2, std::vector<Run> &runs) const
     {
-        //if(!checkTraversability(x1, y1) || !checkTraversability(x2, y2)) //additional check of start and goal traversability,
-        //    return false;                                                //it can be removed if they are already checked
-
         int delta_x = std::abs(x1 - x2);
         int delta_y = std::abs(y1 - y2);
         if((delta_x > delta_y && x1 > x2) || (delta_y >= delta_x && y1 > y2))
@@ -204,34 +309,18 @@ public:
             {
                 error += delta_y;
                 num = (gap - error)/delta_x;
-                for(k = 1; k <= num; k++)
-                    if(map.CellOnGrid(x1 - n*step_x, y1 + k*step_y))
-                        if(map.CellIsObstacle(x1 - n*step_x, y1 + k*step_y))
-                            return false;
-                for(k = 1; k <= num; k++)
-                    if(map.CellOnGrid(x2 + n*step_x, y2 - k*step_y))
-                        if(map.CellIsObstacle(x2 + n*step_x, y2 - k*step_y))
-                            return false;
+                if(num > 0)
+                {
+                    runs.push_back({x1 - n*step_x, std::min(y1 + step_y, y1 + num*step_y), std::max(y1 + step_y, y1 + num*step_y), true});
+                    runs.push_back({x2 + n*step_x, std::min(y2 - step_y, y2 - num*step_y), std::max(y2 - step_y, y2 - num*step_y), true});
+                }
             }
             error = 0;
             for(x = x1; x != x2 + step_x; x+=step_x)
             {
-                if(map.CellIsObstacle(x, y))
-                    return false;
-                if(x < x2 - extraCheck)
-                {
-                    num = (gap + error)/delta_x;
-                    for(k = 1; k <= num; k++)
-                        if(map.CellIsObstacle(x, y + k*step_y))
-                            return false;
-                }
-                if(x > x1 + extraCheck)
-                {
-                    num = (gap - error)/delta_x;
-                    for(k = 1; k <= num; k++)
-                        if(map.CellIsObstacle(x, y - k*step_y))
-                            return false;
-                }
+                k = (x < x2 - extraCheck) ? std::max((gap + error)/delta_x, 0) : 0;   //cells in the direction of step_y
+                num = (x > x1 + extraCheck) ? std::max((gap - error)/delta_x, 0) : 0; //cells in the opposite direction
+                runs.push_back(step_y > 0 ? Run{x, y - num, y + k, false} : Run{x, y - k, y + num, false});
                 error += delta_y;
                 if((error<<1) > delta_x)
                 {
@@ -247,34 +336,18 @@ public:
             {
                 error += delta_x;
                 num = (gap - error)/delta_y;
-                for(k = 1; k <= num; k++)
-                    if(map.CellOnGrid(x1 + k*step_x, y1 - n*step_y))
-                        if(map.CellIsObstacle(x1 + k*step_x, y1 - n*step_y))
-                            return false;
-                for(k = 1; k <= num; k++)
-                    if(map.CellOnGrid(x2 - k*step_x, y2 + n*step_y))
-                        if(map.CellIsObstacle(x2 - k*step_x, y2 + n*step_y))
-                            return false;
+                if(num > 0)
+                {
+                    runs.push_back({y1 - n*step_y, std::min(x1 + step_x, x1 + num*step_x), std::max(x1 + step_x, x1 + num*step_x), true});
+                    runs.push_back({y2 + n*step_y, std::min(x2 - step_x, x2 - num*step_x), std::max(x2 - step_x, x2 - num*step_x), true});
+                }
             }
             error = 0;
             for(y = y1; y != y2 + step_y; y += step_y)
             {
-                if(map.CellIsObstacle(x, y))
-                    return false;
-                if(y < y2 - extraCheck)
-                {
-                    num = (gap + error)/delta_y;
-                    for(k = 1; k <= num; k++)
-                        if(map.CellIsObstacle(x + k*step_x, y))
-                            return false;
-                }
-                if(y > y1 + extraCheck)
-                {
-                    num = (gap - error)/delta_y;
-                    for(k = 1; k <= num; k++)
-                        if(map.CellIsObstacle(x - k*step_x, y))
-                            return false;
-                }
+                k = (y < y2 - extraCheck) ? std::max((gap + error)/delta_y, 0) : 0;   //cells in the direction of step_x
+                num = (y > y1 + extraCheck) ? std::max((gap - error)/delta_y, 0) : 0; //cells in the opposite direction
+                runs.push_back(step_x > 0 ? Run{y, x - num, x + k, false} : Run{y, x - k, x + num, false});
                 error += delta_x;
                 if((error<<1) > delta_y)
                 {
@@ -283,19 +356,35 @@ public:
                 }
             }
         }
-        return true;
     }
-    //checks line-of-sight between a line
-    std::vector<std::pair<int, int>> getCells(int i, int j)
+
+    //the parts of the band near the ends of the line may go out of the grid, such cells are skipped
+    template <class T>
+    bool clippedRowHasObstacle(int x, int y1, int y2, const T &map) const
     {
-        std::vector<std::pair<int, int>> cells;
-        for(int k=0; k<this->cells.size(); k++)
-            cells.push_back({i+this->cells[k].first,j+this->cells[k].second});
-        return cells;
+        if(x < 0 || x >= int(map.height))
+            return false;
+        return map.RowHasObstacle(x, std::max(y1, 0), std::min(y2, int(map.width) - 1));
     }
-private:
+
+    template <class T>
+    bool clippedColumnHasObstacle(int y, int x1, int x2, const T &map) const
+    {
+        if(y < 0 || y >= int(map.width))
+            return false;
+        return map.ColumnHasObstacle(y, std::max(x1, 0), std::min(x2, int(map.height) - 1));
+    }
+
+    static const int movesReach = 3;          //the longest move of the grid, see 'getMoves' of Map
+    static const unsigned int cacheSize = 4096;
     double agentSize;
-    std::vector<std::pair<int, int>> cells; //cells that are affected by agent's body
+    double bodyBound;                         //squared diameter of the body, see 'getClearance' of Map
+    std::vector<std::pair<int, int>> cells;   //cells that are affected by agent's body
+    std::vector<int> halfWidths;              //half-widths of the rows of the body, indexed by the distance from its center
+    std::vector<Pattern> movePatterns;        //patterns of the moves of the grid, indexed by the displacement
+    mutable std::list<std::pair<long long, std::shared_ptr<const Pattern>>> cache; //the most recently used patterns go first
+    mutable std::unordered_map<long long, std::list<std::pair<long long, std::shared_ptr<const Pattern>>>::iterator> cacheIndex;
+    mutable std::mutex cacheGuard;
 };
 
 #endif // LINEOFSIGHT_H
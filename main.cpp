@@ -1,8 +1,64 @@
 #include"mission.h"
+#include"batch.h"
+#include"service.h"
 #include <iostream>
+#include <string>
+#include <cstdlib>
+
+//-batch map-file config-file tasks [obstacles-file] [-threads n]
+int runBatch(int argc, char* argv[])
+{
+    int threads(1);
+    if(argc >= 7 && std::string(argv[argc - 2]) == "-threads")
+    {
+        threads = atoi(argv[argc - 1]);
+        argc -= 2;
+    }
+    if(argc != 5 && argc != 6)
+    {
+        std::cout<<"Wrong arguments of batch mode. It should be: -batch map-file config-file tasks [obstacles-file] [-threads n], "
+                   "where tasks is either a directory with task-files or a text file with one task-file per line.\n";
+        return 0;
+    }
+    Batch batch;
+    batch.setFileNames(argv[4], argv[2], argv[3], argc == 6 ? argv[5] : nullptr);
+    if (!batch.getConfig())
+        return 0;
+    else
+        std::cout<<"CONFIG LOADED\n";
+    if (!batch.getMap())
+    {
+        std::cout<<"Program terminated.\n";
+        return 0;
+    }
+    else
+        std::cout<<"MAP LOADED\n";
+    if(batch.getObstacles())
+        std::cout<<"OBSTACLES LOADED\n";
+    if (!batch.getTasks())
+    {
+        std::cout<<"Program terminated.\n";
+        return 0;
+    }
+    else
+        std::cout<<"TASKS LOADED\n";
+    batch.startSearch(threads);
+    return 1;
+}
 
 int main(int argc, char* argv[])
 {
+    if (argc > 1 && std::string(argv[1]) == "-batch")
+        return runBatch(argc, argv);
+    //-service [socket-name], the requests are read from stdin if the socket is not given
+    if (argc > 1 && std::string(argv[1]) == "-service")
+    {
+        Service service;
+        if(argc == 3)
+            return service.runSocket(argv[2]);
+        service.runStdin();
+        return 1;
+    }
     if (argc > 1)
     {
         Mission mission;
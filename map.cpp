@@ -5,14 +5,64 @@ Map::Map()
 {
     height = 0;
     width = 0;
+    rowStride = 0;
+    columnStride = 0;
+    landmarksLoaded = false;
 }
 Map::~Map()
 {	
     Grid.clear();
 }
 
+//reads a cell from the text between 'begin' and 'end' as extracting an int from it with a stream does: the leading blanks are skipped,
+//the rest of the text after the number is ignored, the text without a number gives 0 and the empty one leaves the cell as it is
+static void parseCell(const char *begin, const char *end, int &cell)
+{
+    while(begin < end && isspace(static_cast<unsigned char>(*begin)))
+        begin++;
+    if(begin == end)
+        return;
+    bool negative(*begin == '-');
+    if(*begin == '-' || *begin == '+')
+        begin++;
+    if(begin == end || !isdigit(static_cast<unsigned char>(*begin)))
+    {
+        cell = 0;
+        return;
+    }
+    long long value(0);
+    for(; begin < end && isdigit(static_cast<unsigned char>(*begin)); begin++)
+        value = std::min(value*10 + (*begin - '0'), static_cast<long long>(INT_MAX) + 1);
+    value = negative ? -value : value;
+    cell = static_cast<int>(std::min(std::max(value, static_cast<long long>(INT_MIN)), static_cast<long long>(INT_MAX)));
+}
+
+//splits the text of a row by single spaces, as the cells have always been separated, and fills the cells in place.
+//Returns the index of the last cell of the text, the cells beyond the width of the row are not stored
+static int parseRow(const char *text, std::vector<int> &row)
+{
+    const char *p(text ? text : "");
+    int j(0);
+    while(true)
+    {
+        const char *token(p);
+        while(*p != '\0' && *p != ' ')
+            p++;
+        if(j < int(row.size()))
+            parseCell(token, p, row[j]);
+        if(*p == '\0')
+            return j;
+        p++;
+        j++;
+    }
+}
+
 bool Map::getMap(const char* FileName)
 {
+    fileName = FileName;
+    landmarks.clear();
+    landmarksLoaded = false;
+    validMoves.clear();
     XMLDocument doc;
     if(doc.LoadFile(FileName) != XMLError::XML_SUCCESS)
     {
@@ -58,9 +108,6 @@ bool Map::getMap(const char* FileName)
     for(int i = 0; i < height; i++)
         Grid[i].resize(width, 0);
 
-    std::string value;
-    const char* rowtext;
-    std::stringstream stream;
     for(int i = 0; i < height; i++)
     {
         if (!row)
@@ -69,31 +116,7 @@ bool Map::getMap(const char* FileName)
             return false;
         }
 
-        rowtext = row->GetText();
-        unsigned int k = 0;
-        value = "";
-        int j = 0;
-
-        for(k = 0; k < strlen(rowtext); k++)
-        {
-            if (rowtext[k] == ' ')
-            {
-                stream << value;
-                stream >> Grid[i][j];
-                stream.clear();
-                stream.str("");
-                value = "";
-                j++;
-            }
-            else
-            {
-                value += rowtext[k];
-            }
-        }
-        stream << value;
-        stream >> Grid[i][j];
-        stream.clear();
-        stream.str("");
+        int j = parseRow(row->GetText(), Grid[i]);
 
         if (j < width-1)
         {
@@ -102,18 +125,168 @@ bool Map::getMap(const char* FileName)
         }
         row = row->NextSiblingElement(CNS_TAG_ROW);
     }
+    packGrid();
+    computeClearance();
     return true;
 }
 
+bool Map::setGrid(const std::vector<std::vector<int>> &grid)
+{
+   if(grid.empty() || grid[0].empty())
+       return false;
+   for(const std::vector<int> &row : grid)
+       if(row.size() != grid[0].size())
+           return false;
+   fileName.clear();
+   landmarks.clear();
+   landmarksLoaded = true;
+   validMoves.clear();
+   Grid = grid;
+   height = grid.size();
+   width = grid[0].size();
+   packGrid();
+   computeClearance();
+   return true;
+}
+
+void Map::packGrid()
+{
+    rowStride = (width + 2*padding + 63)/64;
+    columnStride = (height + 2*padding + 63)/64;
+    rowBits.assign((height + 2*padding)*rowStride, ~0ull);
+    columnBits.assign((width + 2*padding)*columnStride, ~0ull);
+    for(unsigned int i = 0; i < height; i++)
+        for(unsigned int j = 0; j < width; j++)
+            if(Grid[i][j] == 0)
+            {
+                rowBits[(i + padding)*rowStride + (j + padding)/64] &= ~(1ull << (j + padding)%64);
+                columnBits[(j + padding)*columnStride + (i + padding)/64] &= ~(1ull << (i + padding)%64);
+            }
+}
+
+static long long halfCells(long long d)
+{
+    d = std::abs(d);
+    return d == 0 ? 0 : (2*d - 1)*(2*d - 1);
+}
+
+//Sets result[r] to the minimum of itself and (2r - 2k - shift)^2 + values[k] over all k. These are the parabolas centered at 2k + shift,
+//so the minimum is found in linear time by their lower envelope (Felzenszwalb and Huttenlocher), 'v' and 'z' are its buffers.
+static void lowerEnvelope(const std::vector<long long> &values, int shift, std::vector<long long> &result, std::vector<int> &v, std::vector<double> &z)
+{
+    int n(values.size()), k(0);
+    v[0] = 0;
+    z[0] = -std::numeric_limits<double>::infinity();
+    z[1] = std::numeric_limits<double>::infinity();
+    for(int q = 1; q < n; q++)
+    {
+        double s;
+        while(true)
+        {
+            double cq(2.0*q + shift), cp(2.0*v[k] + shift);
+            s = ((values[q] + cq*cq) - (values[v[k]] + cp*cp))/(2*(cq - cp));
+            if(s > z[k])
+                break;
+            k--;
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = std::numeric_limits<double>::infinity();
+    }
+    k = 0;
+    for(int r = 0; r < n; r++)
+    {
+        while(z[k + 1] < 2*r)
+            k++;
+        long long d = 2LL*(r - v[k]) - shift;
+        result[r] = std::min(result[r], d*d + values[v[k]]);
+    }
+}
+
+void Map::computeClearance()
+{
+    //the metric is separable, so the distances to the nearest obstacles of each row are found first and then combined along the columns.
+    //Along a column the rows above the cell add (2(i - i') - 1)^2 and the rows below it add (2(i' - i) - 1)^2, i.e. two families of
+    //parabolas, so each column takes linear time. The rows next to the grid are the obstacles of its border.
+    int h(height), w(width);
+    std::vector<int> nearest(h*w);
+    for(int i = 0; i < h; i++)
+    {
+        int last(-1);
+        for(int j = 0; j < w; j++)
+        {
+            if(Grid[i][j] != 0)
+                last = j;
+            nearest[i*w + j] = j - last;
+        }
+        last = w;
+        for(int j = w - 1; j >= 0; j--)
+        {
+            if(Grid[i][j] != 0)
+                last = j;
+            nearest[i*w + j] = std::min(nearest[i*w + j], last - j);
+        }
+    }
+    clearance.resize(h*w);
+    std::vector<long long> values(h + 2), result(h + 2);
+    std::vector<int> v(h + 2);
+    std::vector<double> z(h + 3);
+    for(int j = 0; j < w; j++)
+    {
+        values[0] = values[h + 1] = 0;
+        for(int i = 0; i < h; i++)
+            values[i + 1] = halfCells(nearest[i*w + j]);
+        result = values;
+        lowerEnvelope(values, 1, result, v, z);  //the rows above, the parabola of the row k is centered at 2k + 1
+        lowerEnvelope(values, -1, result, v, z); //the rows below, centered at 2k - 1
+        for(int i = 0; i < h; i++)
+            clearance[i*w + j] = std::min<long long>(result[i + 1], INT_MAX);
+    }
+}
+
+//tests bits from..to of the given line, all the arguments are already shifted by the padding
+static bool hasBits(const unsigned long long *line, int from, int to)
+{
+    int first(from/64), last(to/64);
+    unsigned long long head(~0ull << from%64), tail(~0ull >> (63 - to%64));
+    if(first == last)
+        return line[first] & head & tail;
+    if(line[first] & head)
+        return true;
+    for(int w = first + 1; w < last; w++)
+        if(line[w])
+            return true;
+    return line[last] & tail;
+}
+
 
 bool Map::CellIsTraversable(int i, int j) const
 {
-    return (Grid[i][j] == 0);
+    return !CellIsObstacle(i, j);
 }
 
 bool Map::CellIsObstacle(int i, int j) const
 {
-    return (Grid[i][j] != 0);
+    return (rowBits[(i + padding)*rowStride + (j + padding)/64] >> (j + padding)%64) & 1;
+}
+
+bool Map::RowHasObstacle(int i, int j1, int j2) const
+{
+    if(j1 > j2)
+        return false;
+    if(i < -padding || i >= int(height) + padding || j1 < -padding || j2 >= int(width) + padding)
+        return true;
+    return hasBits(&rowBits[(i + padding)*rowStride], j1 + padding, j2 + padding);
+}
+
+bool Map::ColumnHasObstacle(int j, int i1, int i2) const
+{
+    if(i1 > i2)
+        return false;
+    if(j < -padding || j >= int(width) + padding || i1 < -padding || i2 >= int(height) + padding)
+        return true;
+    return hasBits(&columnBits[(j + padding)*columnStride], i1 + padding, i2 + padding);
 }
 
 bool Map::CellOnGrid(int i, int j) const
@@ -131,38 +304,263 @@ int Map::getValue(int i, int j) const
     return Grid[i][j];
 }
 
-std::vector<Node> Map::getValidMoves(int i, int j, int k, double size) const
+static std::vector<Node> makeMoves(int k)
 {
-   LineOfSight los;
-   los.setSize(size);
-   std::vector<Node> moves;
    if(k == 2)
-       moves = {Node(0,1,1.0),   Node(1,0,1.0),         Node(-1,0,1.0), Node(0,-1,1.0)};
+       return {Node(0,1,1.0),   Node(1,0,1.0),         Node(-1,0,1.0), Node(0,-1,1.0)};
    else if(k == 3)
-       moves = {Node(0,1,1.0),   Node(1,1,sqrt(2.0)),   Node(1,0,1.0),  Node(1,-1,sqrt(2.0)),
-                Node(0,-1,1.0),  Node(-1,-1,sqrt(2.0)), Node(-1,0,1.0), Node(-1,1,sqrt(2.0))};
+       return {Node(0,1,1.0),   Node(1,1,sqrt(2.0)),   Node(1,0,1.0),  Node(1,-1,sqrt(2.0)),
+               Node(0,-1,1.0),  Node(-1,-1,sqrt(2.0)), Node(-1,0,1.0), Node(-1,1,sqrt(2.0))};
    else if(k == 4)
-       moves = {Node(0,1,1.0),          Node(1,1,sqrt(2.0)),    Node(1,0,1.0),          Node(1,-1,sqrt(2.0)),
-                Node(0,-1,1.0),         Node(-1,-1,sqrt(2.0)),  Node(-1,0,1.0),         Node(-1,1,sqrt(2.0)),
-                Node(1,2,sqrt(5.0)),    Node(2,1,sqrt(5.0)),    Node(2,-1,sqrt(5.0)),   Node(1,-2,sqrt(5.0)),
-                Node(-1,-2,sqrt(5.0)),  Node(-2,-1,sqrt(5.0)),  Node(-2,1,sqrt(5.0)),   Node(-1,2,sqrt(5.0))};
+       return {Node(0,1,1.0),          Node(1,1,sqrt(2.0)),    Node(1,0,1.0),          Node(1,-1,sqrt(2.0)),
+               Node(0,-1,1.0),         Node(-1,-1,sqrt(2.0)),  Node(-1,0,1.0),         Node(-1,1,sqrt(2.0)),
+               Node(1,2,sqrt(5.0)),    Node(2,1,sqrt(5.0)),    Node(2,-1,sqrt(5.0)),   Node(1,-2,sqrt(5.0)),
+               Node(-1,-2,sqrt(5.0)),  Node(-2,-1,sqrt(5.0)),  Node(-2,1,sqrt(5.0)),   Node(-1,2,sqrt(5.0))};
    else
-       moves = {Node(0,1,1.0),          Node(1,1,sqrt(2.0)),    Node(1,0,1.0),          Node(1,-1,sqrt(2.0)),
-                Node(0,-1,1.0),         Node(-1,-1,sqrt(2.0)),  Node(-1,0,1.0),         Node(-1,1,sqrt(2.0)),
-                Node(1,2,sqrt(5.0)),    Node(2,1,sqrt(5.0)),    Node(2,-1,sqrt(5.0)),   Node(1,-2,sqrt(5.0)),
-                Node(-1,-2,sqrt(5.0)),  Node(-2,-1,sqrt(5.0)),  Node(-2,1,sqrt(5.0)),   Node(-1,2,sqrt(5.0)),
-                Node(1,3,sqrt(10.0)),   Node(2,3,sqrt(13.0)),   Node(3,2,sqrt(13.0)),   Node(3,1,sqrt(10.0)),
-                Node(3,-1,sqrt(10.0)),  Node(3,-2,sqrt(13.0)),  Node(2,-3,sqrt(13.0)),  Node(1,-3,sqrt(10.0)),
-                Node(-1,-3,sqrt(10.0)), Node(-2,-3,sqrt(13.0)), Node(-3,-2,sqrt(13.0)), Node(-3,-1,sqrt(10.0)),
-                Node(-3,1,sqrt(10.0)),  Node(-3,2,sqrt(13.0)),  Node(-2,3,sqrt(13.0)),  Node(-1,3,sqrt(10.0))};
-   std::vector<bool> valid(moves.size(), true);
-   for(int k = 0; k < moves.size(); k++)
-       if(!CellOnGrid(i + moves[k].i, j + moves[k].j) || CellIsObstacle(i + moves[k].i, j + moves[k].j)
-               || !los.checkLine(i, j, i + moves[k].i, j + moves[k].j, *this))
-           valid[k] = false;
-   std::vector<Node> v_moves = {};
-   for(int k = 0; k < valid.size(); k++)
-       if(valid[k])
-           v_moves.push_back(moves[k]);
-   return v_moves;
+       return {Node(0,1,1.0),          Node(1,1,sqrt(2.0)),    Node(1,0,1.0),          Node(1,-1,sqrt(2.0)),
+               Node(0,-1,1.0),         Node(-1,-1,sqrt(2.0)),  Node(-1,0,1.0),         Node(-1,1,sqrt(2.0)),
+               Node(1,2,sqrt(5.0)),    Node(2,1,sqrt(5.0)),    Node(2,-1,sqrt(5.0)),   Node(1,-2,sqrt(5.0)),
+               Node(-1,-2,sqrt(5.0)),  Node(-2,-1,sqrt(5.0)),  Node(-2,1,sqrt(5.0)),   Node(-1,2,sqrt(5.0)),
+               Node(1,3,sqrt(10.0)),   Node(2,3,sqrt(13.0)),   Node(3,2,sqrt(13.0)),   Node(3,1,sqrt(10.0)),
+               Node(3,-1,sqrt(10.0)),  Node(3,-2,sqrt(13.0)),  Node(2,-3,sqrt(13.0)),  Node(1,-3,sqrt(10.0)),
+               Node(-1,-3,sqrt(10.0)), Node(-2,-3,sqrt(13.0)), Node(-3,-2,sqrt(13.0)), Node(-3,-1,sqrt(10.0)),
+               Node(-3,1,sqrt(10.0)),  Node(-3,2,sqrt(13.0)),  Node(-2,3,sqrt(13.0)),  Node(-1,3,sqrt(10.0))};
+}
+
+const std::vector<Node>& Map::getMoves(int k)
+{
+   static const std::vector<Node> moves[4] = {makeMoves(2), makeMoves(3), makeMoves(4), makeMoves(5)};
+   return moves[k == 2 ? 0 : k == 3 ? 1 : k == 4 ? 2 : 3];
+}
+
+unsigned int Map::computeValidMoves(int i, int j, int k, const LineOfSight &los) const
+{
+   const std::vector<Node> &all = getMoves(k);
+   unsigned int mask(0);
+   for(unsigned int n = 0; n < all.size(); n++)
+   {
+       int i2(i + all[n].i), j2(j + all[n].j);
+       if(CellOnGrid(i2, j2) && !CellIsObstacle(i2, j2) && los.checkTraversability(i2, j2, *this) && los.checkLine(i, j, i2, j2, *this))
+           mask |= 1u << n;
+   }
+   return mask;
+}
+
+const Map::MoveMasks* Map::findValidMoves(int k, double size) const
+{
+   for(const MoveMasks &m : validMoves)
+       if(m.k == k && fabs(m.size - size) < CN_EPSILON)
+           return &m;
+   return nullptr;
+}
+
+void Map::getValidMoves(int i, int j, int k, const LineOfSight &los, std::vector<Node> &moves) const
+{
+   moves.clear();
+   const std::vector<Node> &all = getMoves(k);
+   const MoveMasks *cached = findValidMoves(k, los.getSize());
+   unsigned int mask = cached ? cached->masks[i*width + j] : computeValidMoves(i, j, k, los);
+   for(unsigned int n = 0; mask; n++, mask >>= 1)
+       if(mask & 1)
+           moves.push_back(all[n]);
+}
+
+void Map::computeDistances(int i, int j, int k, const LineOfSight &los, std::vector<float> &distances) const
+{
+   std::vector<double> dist(height*width, CN_INFINITY);
+   std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<std::pair<double, int>>> queue;
+   std::vector<Node> moves;
+   dist[i*width + j] = 0;
+   queue.push({0, i*width + j});
+   while(!queue.empty())
+   {
+       std::pair<double, int> top = queue.top();
+       queue.pop();
+       if(top.first > dist[top.second])
+           continue;
+       int ci(top.second/width), cj(top.second%width);
+       getValidMoves(ci, cj, k, los, moves);
+       for(const Node &m : moves)
+       {
+           int next((ci + m.i)*width + cj + m.j);
+           if(top.first + m.g < dist[next])
+           {
+               dist[next] = top.first + m.g;
+               queue.push({dist[next], next});
+           }
+       }
+   }
+   //the distances are used as lower bounds, so they are rounded down to floats
+   distances.resize(height*width);
+   for(unsigned int n = 0; n < dist.size(); n++)
+   {
+       distances[n] = dist[n];
+       if(distances[n] > dist[n])
+           distances[n] = std::nextafter(distances[n], 0.0f);
+   }
+}
+
+std::string Map::getLandmarksFileName() const
+{
+    return fileName + ".landmarks";
+}
+
+unsigned long long Map::getGridHash() const
+{
+    //FNV-1a over the sizes and the obstacles, the file is ignored if the map has changed since it was written
+    unsigned long long hash = 14695981039346656037ull;
+    auto add = [&hash](unsigned int value)
+    {
+        hash = (hash ^ value)*1099511628211ull;
+    };
+    add(height);
+    add(width);
+    for(unsigned int i = 0; i < height; i++)
+        for(unsigned int j = 0; j < width; j++)
+            add(Grid[i][j] != 0);
+    return hash;
+}
+
+//The file starts with CN_LANDMARKS_MAGIC, the version, the sizes of the grid and its hash, then goes the number of sets of landmarks.
+//Each set is stored as its connectedness, agent size, number of landmarks, their cells and their tables.
+void Map::loadLandmarks()
+{
+    landmarksLoaded = true;
+    std::ifstream in(getLandmarksFileName().c_str(), std::ios::binary);
+    if(!in)
+        return;
+    char magic[sizeof(CN_LANDMARKS_MAGIC)];
+    unsigned int version(0), h(0), w(0), sets(0);
+    unsigned long long hash(0);
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    in.read(reinterpret_cast<char*>(&h), sizeof(h));
+    in.read(reinterpret_cast<char*>(&w), sizeof(w));
+    in.read(reinterpret_cast<char*>(&hash), sizeof(hash));
+    in.read(reinterpret_cast<char*>(&sets), sizeof(sets));
+    if(!in || std::string(magic, sizeof(magic)) != std::string(CN_LANDMARKS_MAGIC, sizeof(magic)) || version != CN_LANDMARKS_VERSION
+            || h != height || w != width || hash != getGridHash())
+    {
+        std::cout << "Warning! File '" << getLandmarksFileName() << "' doesn't match the map. The landmarks will be computed again." << std::endl;
+        return;
+    }
+    std::deque<Landmarks> loaded;
+    for(unsigned int s = 0; s < sets; s++)
+    {
+        Landmarks set;
+        unsigned int count(0);
+        in.read(reinterpret_cast<char*>(&set.k), sizeof(set.k));
+        in.read(reinterpret_cast<char*>(&set.size), sizeof(set.size));
+        in.read(reinterpret_cast<char*>(&count), sizeof(count));
+        if(!in || count > height*width)
+            break;
+        set.cells.resize(count);
+        set.distances.resize(count*height*width);
+        in.read(reinterpret_cast<char*>(set.cells.data()), count*sizeof(int));
+        in.read(reinterpret_cast<char*>(set.distances.data()), set.distances.size()*sizeof(float));
+        if(!in)
+            break;
+        loaded.push_back(std::move(set));
+    }
+    if(loaded.size() != sets)
+    {
+        std::cout << "Warning! File '" << getLandmarksFileName() << "' is damaged. The landmarks will be computed again." << std::endl;
+        return;
+    }
+    landmarks = std::move(loaded);
+}
+
+void Map::saveLandmarks() const
+{
+    std::ofstream out(getLandmarksFileName().c_str(), std::ios::binary | std::ios::trunc);
+    unsigned int version(CN_LANDMARKS_VERSION), sets(landmarks.size());
+    unsigned long long hash(getGridHash());
+    out.write(CN_LANDMARKS_MAGIC, sizeof(CN_LANDMARKS_MAGIC));
+    out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    out.write(reinterpret_cast<const char*>(&height), sizeof(height));
+    out.write(reinterpret_cast<const char*>(&width), sizeof(width));
+    out.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+    out.write(reinterpret_cast<const char*>(&sets), sizeof(sets));
+    for(const Landmarks &set : landmarks)
+    {
+        unsigned int count(set.cells.size());
+        out.write(reinterpret_cast<const char*>(&set.k), sizeof(set.k));
+        out.write(reinterpret_cast<const char*>(&set.size), sizeof(set.size));
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        out.write(reinterpret_cast<const char*>(set.cells.data()), count*sizeof(int));
+        out.write(reinterpret_cast<const char*>(set.distances.data()), set.distances.size()*sizeof(float));
+    }
+    if(!out)
+        std::cout << "Warning! Can't write file '" << getLandmarksFileName() << "'. The landmarks will be computed again next time." << std::endl;
+}
+
+const Landmarks* Map::getLandmarks(int k, double size) const
+{
+    for(const Landmarks &set : landmarks)
+        if(set.k == k && fabs(set.size - size) < CN_EPSILON)
+            return &set;
+    return nullptr;
+}
+
+void Map::prepareLandmarks(int k, const LineOfSight &los)
+{
+    if(!landmarksLoaded)
+        loadLandmarks();
+    if(getLandmarks(k, los.getSize()))
+        return;
+    Landmarks set;
+    set.k = k;
+    set.size = los.getSize();
+    //farthest-point placement: each landmark is the cell farthest from the ones placed before (the unreachable cells are the farthest),
+    //the search from the first free cell only finds a good place for the first landmark
+    int cells(height*width);
+    std::vector<float> nearest(cells, CN_INFINITY), table;
+    for(int n = 0; n < cells; n++)
+        if(los.checkTraversability(n/width, n%width, *this))
+        {
+            computeDistances(n/width, n%width, k, los, nearest);
+            break;
+        }
+    for(int l = 0; l < CN_NUMBER_OF_LANDMARKS; l++)
+    {
+        int farthest(-1);
+        for(int n = 0; n < cells; n++)
+            if((farthest < 0 || nearest[n] > nearest[farthest]) && los.checkTraversability(n/width, n%width, *this))
+                farthest = n;
+        if(farthest < 0 || nearest[farthest] == 0)
+            break;
+        computeDistances(farthest/width, farthest%width, k, los, table);
+        set.cells.push_back(farthest);
+        set.distances.insert(set.distances.end(), table.begin(), table.end());
+        for(int n = 0; n < cells; n++)
+            nearest[n] = std::min(nearest[n], table[n]);
+    }
+    landmarks.push_back(std::move(set));
+    if(!fileName.empty())
+        saveLandmarks();
+}
+
+void Map::prepareValidMoves(int k, const LineOfSight &los)
+{
+   if(findValidMoves(k, los.getSize()))
+       return;
+   MoveMasks cache;
+   cache.k = k;
+   cache.size = los.getSize();
+   cache.masks.resize(height*width);
+   //rows are independent, so they are split between the threads, small maps are not worth starting them
+   unsigned int threads = std::min<unsigned int>(std::max(std::thread::hardware_concurrency(), 1u), height*width/4096 + 1);
+   auto fill = [&](unsigned int first)
+   {
+       for(unsigned int i = first; i < height; i += threads)
+           for(unsigned int j = 0; j < width; j++)
+               cache.masks[i*width + j] = computeValidMoves(i, j, k, los);
+   };
+   std::vector<std::thread> workers;
+   for(unsigned int t = 1; t < threads; t++)
+       workers.emplace_back(fill, t);
+   fill(0);
+   for(std::thread &w : workers)
+       w.join();
+   validMoves.push_back(std::move(cache));
 }
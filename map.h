@@ -10,6 +10,23 @@
 #include "tinyxml2.h"
 #include "gl_const.h"
 #include "lineofsight.h"
+#include <thread>
+#include <climits>
+#include <cctype>
+#include <queue>
+#include <cmath>
+#include <limits>
+#include <deque>
+#include <fstream>
+
+//tables of the distances from a few landmarks to all the cells, they give the lower bounds |d(L, a) - d(L, b)| of the distances between any cells
+struct Landmarks
+{
+    int k;
+    double size;
+    std::vector<int> cells;       //i*width + j of each landmark
+    std::vector<float> distances; //distances from the landmarks to all the cells, one table after another
+};
 
 class Map
 {
@@ -21,11 +38,57 @@ public:
     Map();
     ~Map();
     bool getMap(const char* FileName);
+    //takes the grid from memory, 0 is a traversable cell. Such a map has no file, so its landmarks are not saved
+    bool setGrid(const std::vector<std::vector<int>> &grid);
     bool CellIsTraversable (int i, int j) const;
     bool CellOnGrid (int i, int j) const;
     bool CellIsObstacle(int i, int j) const;
+    bool RowHasObstacle(int i, int j1, int j2) const;    //checks cells (i, j1..j2), the cells out of the grid are obstacles
+    bool ColumnHasObstacle(int j, int i1, int i2) const; //checks cells (i1..i2, j), the cells out of the grid are obstacles
     int  getValue(int i, int j) const;
-    std::vector<Node> getValidMoves(int i, int j, int k, double size) const;
+    //squared distance from the center of the cell to the nearest obstacle or border of the grid measured in half-cells,
+    //i.e. the minimum of (2|di| - 1)^2 + (2|dj| - 1)^2 over the obstacles, where a zero offset adds zero
+    int  getClearance(int i, int j) const { return clearance[i*width + j]; }
+    static const std::vector<Node>& getMoves(int k);
+    //returns the moves to the cells that the agent can reach without colliding with the static obstacles
+    void getValidMoves(int i, int j, int k, const LineOfSight &los, std::vector<Node> &moves) const;
+    //precomputes bitmasks of the valid moves of all cells for the agents of the given size, so getValidMoves doesn't check the lines anymore
+    void prepareValidMoves(int k, const LineOfSight &los);
+    //Dijkstra from (i, j) over the valid moves, the lengths of the shortest paths of all cells (CN_INFINITY if unreachable) are written
+    //into 'distances'. The moves are symmetric, so these are the distances both to and from (i, j).
+    void computeDistances(int i, int j, int k, const LineOfSight &los, std::vector<float> &distances) const;
+    //loads the landmarks for the agents of the given size from the file next to the map (see 'getLandmarksFileName'),
+    //or places them and computes their tables, then saves the tables to that file, so the next runs on the same map just load them
+    void prepareLandmarks(int k, const LineOfSight &los);
+    const Landmarks* getLandmarks(int k, double size) const;
+
+private:
+    void packGrid();
+    void computeClearance();
+    //obstacles packed into bits. Every line is padded by 'padding' obstacle cells on both sides, so the footprints near the borders
+    //can be tested without checking the bounds. The second copy is transposed, so the columns are tested by words as well.
+    static const int padding = 64;
+    std::vector<unsigned long long> rowBits, columnBits;
+    int rowStride, columnStride;
+    std::vector<int> clearance;
+
+    struct MoveMasks
+    {
+        int k;
+        double size;
+        std::vector<unsigned int> masks; //bit n of the mask of a cell is set if the n-th move of getMoves(k) is valid
+    };
+    unsigned int computeValidMoves(int i, int j, int k, const LineOfSight &los) const;
+    const MoveMasks* findValidMoves(int k, double size) const;
+    std::vector<MoveMasks> validMoves;
+
+    std::string getLandmarksFileName() const;
+    unsigned long long getGridHash() const;
+    void loadLandmarks();
+    void saveLandmarks() const;
+    std::string fileName;
+    bool landmarksLoaded;
+    std::deque<Landmarks> landmarks; //deque keeps the pointers given by getLandmarks valid
 };
 
 #endif
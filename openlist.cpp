@@ -0,0 +1,177 @@
+#include "openlist.h"
+
+OpenList::OpenList()
+{
+    counter = 0;
+    width = 0;
+}
+
+void OpenList::resize(int width, int height)
+{
+    this->width = width;
+    cellHead.assign(width*height, -1);
+    nodes.clear();
+    order.clear();
+    position.clear();
+    next.clear();
+    heap.clear();
+    freeSlots.clear();
+    counter = 0;
+}
+
+void OpenList::clear()
+{
+    for(unsigned int k = 0; k < heap.size(); k++)
+        cellHead[nodes[heap[k]].i*width + nodes[heap[k]].j] = -1;
+    nodes.clear();
+    order.clear();
+    position.clear();
+    next.clear();
+    heap.clear();
+    freeSlots.clear();
+    counter = 0;
+}
+
+bool OpenList::less(int a, int b) const
+{
+    const SearchNode &na = nodes[a], &nb = nodes[b];
+    if(fabs(na.F - nb.F) >= CN_EPSILON)
+        return na.F < nb.F;
+    if(na.g != nb.g)
+        return na.g > nb.g;
+    if(na.i != nb.i)
+        return na.i < nb.i;
+    return order[a] < order[b];
+}
+
+void OpenList::siftUp(int pos)
+{
+    int slot = heap[pos];
+    while(pos > 0)
+    {
+        int parent = (pos - 1)/2;
+        if(!less(slot, heap[parent]))
+            break;
+        heap[pos] = heap[parent];
+        position[heap[pos]] = pos;
+        pos = parent;
+    }
+    heap[pos] = slot;
+    position[slot] = pos;
+}
+
+void OpenList::siftDown(int pos)
+{
+    int slot = heap[pos];
+    int size = heap.size();
+    while(2*pos + 1 < size)
+    {
+        int child = 2*pos + 1;
+        if(child + 1 < size && less(heap[child + 1], heap[child]))
+            child++;
+        if(!less(heap[child], slot))
+            break;
+        heap[pos] = heap[child];
+        position[heap[pos]] = pos;
+        pos = child;
+    }
+    heap[pos] = slot;
+    position[slot] = pos;
+}
+
+void OpenList::link(int slot)
+{
+    int cell = nodes[slot].i*width + nodes[slot].j;
+    next[slot] = cellHead[cell];
+    cellHead[cell] = slot;
+}
+
+void OpenList::unlink(int slot)
+{
+    int cell = nodes[slot].i*width + nodes[slot].j;
+    if(cellHead[cell] == slot)
+    {
+        cellHead[cell] = next[slot];
+        return;
+    }
+    for(int k = cellHead[cell]; k >= 0; k = next[k])
+        if(next[k] == slot)
+        {
+            next[k] = next[slot];
+            return;
+        }
+}
+
+void OpenList::release(int slot)
+{
+    unlink(slot);
+    int pos = position[slot];
+    int last = heap.back();
+    heap.pop_back();
+    position[slot] = -1;
+    freeSlots.push_back(slot);
+    if(last == slot)
+        return;
+    heap[pos] = last;
+    position[last] = pos;
+    if(pos > 0 && less(last, heap[(pos - 1)/2]))
+        siftUp(pos);
+    else
+        siftDown(pos);
+}
+
+void OpenList::push(const SearchNode &node)
+{
+    int slot;
+    if(freeSlots.empty())
+    {
+        slot = nodes.size();
+        nodes.push_back(node);
+        order.push_back(counter++);
+        position.push_back(-1);
+        next.push_back(-1);
+    }
+    else
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+        nodes[slot] = node;
+        order[slot] = counter++;
+    }
+    link(slot);
+    heap.push_back(slot);
+    siftUp(heap.size() - 1);
+}
+
+SearchNode OpenList::pop()
+{
+    SearchNode min = nodes[heap.front()];
+    release(heap.front());
+    return min;
+}
+
+int OpenList::findState(int i, int j, int id, int from) const
+{
+    int slot = (from < 0) ? cellHead[i*width + j] : next[from];
+    for(; slot >= 0; slot = next[slot])
+        if(nodes[slot].interval_id == id)
+            return slot;
+    return -1;
+}
+
+void OpenList::update(int slot, const SearchNode &node)
+{
+    //the node is always in the same cell, so the chain stays the same. It ties as the newest node, as if it was removed and pushed again
+    nodes[slot] = node;
+    order[slot] = counter++;
+    int pos = position[slot];
+    if(pos > 0 && less(slot, heap[(pos - 1)/2]))
+        siftUp(pos);
+    else
+        siftDown(pos);
+}
+
+void OpenList::remove(int slot)
+{
+    release(slot);
+}
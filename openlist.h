@@ -0,0 +1,50 @@
+/* This class implements OPEN list of AA-SIPP as an indexed binary heap.
+ * Nodes are ordered by F-value, ties are broken in favour of the nodes with greater g-value.
+ * Each stored node is also linked into a chain of its cell, so the states that correspond to the same
+ * (cell, safe interval) pair can be found and updated (decrease-key) without scanning the whole list.
+ * An updated node ties with the others as the newest one, the same as a node that was removed and pushed again.
+ */
+
+#ifndef OPENLIST_H
+#define OPENLIST_H
+#include "gl_const.h"
+#include "structs.h"
+#include <vector>
+#include <math.h>
+
+class OpenList
+{
+public:
+    OpenList();
+    void resize(int width, int height);
+    void clear();
+    bool empty() const { return heap.empty(); }
+    unsigned int size() const { return heap.size(); }
+    const SearchNode& top() const { return nodes[heap.front()]; }
+    SearchNode pop();
+    void push(const SearchNode &node);
+    int findState(int i, int j, int id, int from = -1) const; //returns the slot of the next stored node with the same (i, j, interval_id) or -1
+    const SearchNode& getNode(int slot) const { return nodes[slot]; }
+    void update(int slot, const SearchNode &node);
+    void remove(int slot);
+
+private:
+    bool less(int a, int b) const;
+    void siftUp(int pos);
+    void siftDown(int pos);
+    void link(int slot);
+    void unlink(int slot);
+    void release(int slot);
+
+    std::vector<SearchNode> nodes;      //storage of the nodes, indexed by slots
+    std::vector<unsigned long> order;   //insertion (or the last update) order of each slot, used as the last tie-breaker
+    std::vector<int> position;          //position of each slot in the heap
+    std::vector<int> next;              //next slot in the chain of the same cell
+    std::vector<int> heap;
+    std::vector<int> freeSlots;
+    std::vector<int> cellHead;          //first slot of each cell's chain
+    unsigned long counter;
+    int width;
+};
+
+#endif // OPENLIST_H
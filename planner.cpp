@@ -0,0 +1,42 @@
+#include "planner.h"
+
+Planner::Planner(const Config &config):config(config)
+{
+    mapLoaded = false;
+}
+
+bool Planner::setMap(const std::vector<std::vector<int>> &grid)
+{
+    mapLoaded = map.setGrid(grid);
+    obstacleLayer = nullptr;
+    return mapLoaded;
+}
+
+void Planner::setObstacles(const std::vector<obstacle> &obstacles)
+{
+    this->obstacles = DynamicObstacles();
+    for(const obstacle &obs : obstacles)
+        this->obstacles.addObstacle(obs);
+    obstacleLayer = nullptr;
+}
+
+bool Planner::plan(const std::vector<Agent> &agents, SearchResult &result)
+{
+    Task task;
+    for(const Agent &agent : agents)
+        task.addAgent(agent);
+    error.clear();
+    if(!mapLoaded)
+        error = "No map is set.";
+    else if(agents.empty())
+        error = "No agents are given.";
+    if(!error.empty() || !task.validateTask(map, error))
+        return false;
+    if(!obstacleLayer)
+        obstacleLayer = AA_SIPP::buildObstacleLayer(map, obstacles);
+    AA_SIPP search(config);
+    search.setObstacleLayer(obstacleLayer);
+    search.setMessageHandler(handler ? handler : [](const std::string&){});
+    result = search.startSearch(map, task, obstacles);
+    return true;
+}
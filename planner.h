@@ -0,0 +1,48 @@
+/* This class is the in-memory interface of the planner for the programs that embed the library.
+ * The map, the agents and the dynamic obstacles are given by the structures of the caller, nothing is read from
+ * or written to the files and nothing is printed: the reason of a failed call is given by 'getError' and the messages
+ * of the search go to the handler set by 'setMessageHandler'. The map keeps its caches and the constraints of the obstacles are built once,
+ * so the next calls of 'plan' on the same map and obstacles only pay for the search itself.
+ * One Planner runs one search at a time; the separate Planners are independent.
+ */
+
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include "map.h"
+#include "config.h"
+#include "searchresult.h"
+#include "aa_sipp.h"
+#include "task.h"
+#include "dynamicobstacles.h"
+#include <vector>
+#include <memory>
+#include <string>
+#include <functional>
+
+class Planner
+{
+public:
+    Planner(const Config &config = Config());
+    void setConfig(const Config &config) { this->config = config; }
+    //rows of the grid, 0 is a traversable cell, any other value is an obstacle. Returns false if the rows differ in length
+    bool setMap(const std::vector<std::vector<int>> &grid);
+    void setObstacles(const std::vector<obstacle> &obstacles);
+    //returns false if there is no map or no agents, or some agent stands on or goes to an untraversable position
+    bool plan(const std::vector<Agent> &agents, SearchResult &result);
+    const std::string& getError() const { return error; } //why the last call of 'plan' has failed
+    //the messages of the search, e.g. the agents that have no path, are dropped if the handler is not set (see AA_SIPP::setMessageHandler)
+    void setMessageHandler(std::function<void(const std::string&)> handler) { this->handler = handler; }
+    const Map& getMap() const { return map; }
+
+private:
+    Config config;
+    Map map;
+    bool mapLoaded;
+    DynamicObstacles obstacles;
+    std::shared_ptr<const Constraints> obstacleLayer;
+    std::string error;
+    std::function<void(const std::string&)> handler;
+};
+
+#endif // PLANNER_H
@@ -0,0 +1,105 @@
+#include "sectionbuffer.h"
+#include "sectionkernel.h"
+#include <math.h>
+#include <algorithm>
+#ifdef SECTIONS_SIMD
+#include <emmintrin.h>
+#endif
+
+struct ScalarTraits
+{
+    typedef double V;
+    typedef bool M;
+    static const int width = 1;
+    static V set(double x) { return x; }
+    static V load(const double *p) { return *p; }
+    static void store(double *p, V x) { *p = x; }
+    static V sqrt(V x) { return ::sqrt(x); }
+    static V abs(V x) { return fabs(x); }
+    static V min(V a, V b) { return b < a ? b : a; }
+    static V max(V a, V b) { return a < b ? b : a; }
+    static M less(V a, V b) { return a < b; }
+    static M notGreater(V a, V b) { return a <= b; }
+    static M both(M a, M b) { return a && b; }
+    static V select(M m, V a, V b) { return m ? a : b; }
+    static M select(M m, M a, M b) { return m ? a : b; }
+};
+
+void getUnsafeWindowsScalar(SectionBuffer &buffer, double pi, double pj, double vai, double vaj, double duration, double radius)
+{
+    getUnsafeWindowsKernel<ScalarTraits>(buffer, pi, pj, vai, vaj, duration, radius);
+}
+
+#ifdef SECTIONS_SIMD
+struct Sse2Traits
+{
+    typedef __m128d V;
+    typedef __m128d M;
+    static const int width = 2;
+    static V set(double x) { return _mm_set1_pd(x); }
+    static V load(const double *p) { return _mm_loadu_pd(p); }
+    static void store(double *p, V x) { _mm_storeu_pd(p, x); }
+    static V sqrt(V x) { return _mm_sqrt_pd(x); }
+    static V abs(V x) { return _mm_andnot_pd(_mm_set1_pd(-0.0), x); }
+    static V min(V a, V b) { return _mm_min_pd(b, a); }
+    static V max(V a, V b) { return _mm_max_pd(b, a); }
+    static M less(V a, V b) { return _mm_cmplt_pd(a, b); }
+    static M notGreater(V a, V b) { return _mm_cmple_pd(a, b); }
+    static M both(M a, M b) { return _mm_and_pd(a, b); }
+    static V select(M m, V a, V b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+};
+
+void getUnsafeWindowsSse2(SectionBuffer &buffer, double pi, double pj, double vai, double vaj, double duration, double radius)
+{
+    getUnsafeWindowsKernel<Sse2Traits>(buffer, pi, pj, vai, vaj, duration, radius);
+}
+#endif
+
+void SectionBuffer::clear()
+{
+    count = 0;
+    bi.clear();
+    bj.clear();
+    vbi.clear();
+    vbj.clear();
+    g1.clear();
+    g2.clear();
+    sizes.clear();
+}
+
+void SectionBuffer::add(const section &sec)
+{
+    count++;
+    bi.push_back(sec.i1);
+    bj.push_back(sec.j1);
+    if(sec.g2 < CN_INFINITY && sec.g2 - sec.g1 > CN_EPSILON)
+    {
+        vbi.push_back((sec.i2 - sec.i1)/(sec.g2 - sec.g1));
+        vbj.push_back((sec.j2 - sec.j1)/(sec.g2 - sec.g1));
+    }
+    else
+    {
+        vbi.push_back(0);
+        vbj.push_back(0);
+    }
+    g1.push_back(sec.g1);
+    g2.push_back(sec.g2);
+    sizes.push_back(sec.size);
+}
+
+void SectionBuffer::getUnsafeWindows(const SearchNode &curNode, const SearchNode &parent, double radius)
+{
+    unsigned int padded = (count + padding - 1)/padding*padding;
+    for(std::vector<double> *v : {&bi, &bj, &vbi, &vbj, &g1, &g2, &sizes})
+        v->resize(padded, 0);
+    begins.resize(padded);
+    ends.resize(padded);
+    double duration(curNode.g - parent.g);
+    double vai((curNode.i - parent.i)/duration), vaj((curNode.j - parent.j)/duration);
+#ifdef SECTIONS_SIMD
+    if(!getUnsafeWindowsAvx2(*this, parent.i, parent.j, vai, vaj, duration, radius))
+        getUnsafeWindowsSse2(*this, parent.i, parent.j, vai, vaj, duration, radius);
+#else
+    getUnsafeWindowsScalar(*this, parent.i, parent.j, vai, vaj, duration, radius);
+#endif
+}
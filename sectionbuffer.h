@@ -0,0 +1,40 @@
+/* This class keeps the sections checked by Constraints::findIntervals as a structure of arrays,
+ * so the unsafe departure windows of many sections can be computed at once with SIMD instructions.
+ * AVX2 (4 sections per step) is used if the CPU supports it, otherwise SSE2 (2 sections per step)
+ * or plain scalar code on the platforms without SSE2.
+ */
+
+#ifndef SECTIONBUFFER_H
+#define SECTIONBUFFER_H
+#include "gl_const.h"
+#include "structs.h"
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+    #define SECTIONS_SIMD
+#endif
+
+class SectionBuffer
+{
+public:
+    SectionBuffer():count(0){}
+    void clear();
+    void add(const section &sec);
+    unsigned int size() const { return count; }
+    //computes the windows (begin[k], end[k]) of departure times from 'parent' to 'curNode' that lead to collision with section k,
+    //begin[k] >= end[k] means that any departure is safe
+    void getUnsafeWindows(const SearchNode &curNode, const SearchNode &parent, double radius);
+    double begin(unsigned int k) const { return begins[k]; }
+    double end(unsigned int k) const { return ends[k]; }
+
+    //the storage is padded to the width of the widest SIMD register, so the kernels never process a partial step
+    static const int padding = 4;
+    unsigned int count;
+    std::vector<double> bi, bj;   //start position
+    std::vector<double> vbi, vbj; //velocity, zero for the sections that never end
+    std::vector<double> g1, g2;
+    std::vector<double> sizes;
+    std::vector<double> begins, ends;
+};
+
+#endif // SECTIONBUFFER_H
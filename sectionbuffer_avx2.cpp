@@ -0,0 +1,53 @@
+/* AVX2 instantiation of the unsafe windows kernel. The whole translation unit is compiled for AVX2,
+ * but its only entry point checks the CPU at runtime and refuses to run on the processors without it.
+ */
+
+#include "sectionbuffer.h"
+
+#ifdef SECTIONS_SIMD
+#include <immintrin.h>
+
+static bool avx2Supported()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#include "sectionkernel.h" //the kernel is instantiated inside the AVX2 region, so it has to be defined there
+
+struct Avx2Traits
+{
+    typedef __m256d V;
+    typedef __m256d M;
+    static const int width = 4;
+    static V set(double x) { return _mm256_set1_pd(x); }
+    static V load(const double *p) { return _mm256_loadu_pd(p); }
+    static void store(double *p, V x) { _mm256_storeu_pd(p, x); }
+    static V sqrt(V x) { return _mm256_sqrt_pd(x); }
+    static V abs(V x) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), x); }
+    static V min(V a, V b) { return _mm256_min_pd(b, a); }
+    static V max(V a, V b) { return _mm256_max_pd(b, a); }
+    static M less(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    static M notGreater(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+    static M both(M a, M b) { return _mm256_and_pd(a, b); }
+    static V select(M m, V a, V b) { return _mm256_blendv_pd(b, a, m); }
+};
+
+static void getUnsafeWindowsAvx2Kernel(SectionBuffer &buffer, double pi, double pj, double vai, double vaj, double duration, double radius)
+{
+    getUnsafeWindowsKernel<Avx2Traits>(buffer, pi, pj, vai, vaj, duration, radius);
+}
+
+#pragma GCC pop_options
+
+bool getUnsafeWindowsAvx2(SectionBuffer &buffer, double pi, double pj, double vai, double vaj, double duration, double radius)
+{
+    static const bool supported = avx2Supported();
+    if(!supported)
+        return false;
+    getUnsafeWindowsAvx2Kernel(buffer, pi, pj, vai, vaj, duration, radius);
+    return true;
+}
+#endif
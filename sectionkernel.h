@@ -0,0 +1,93 @@
+/* The kernel that computes unsafe departure windows for the sections of SectionBuffer.
+ * It is written once over a set of traits (register type, mask type and a few operations)
+ * and instantiated for plain doubles, SSE2 and AVX2 registers.
+ *
+ * Departure at s puts the agent at P + VA*tau, tau in [0, duration], and the section at B + VB*(s + tau - g1), s + tau in [g1, g2].
+ * Their difference a + VB*s + v*tau is shorter than the combined radius inside an ellipse (or a strip) on the (s, tau) plane,
+ * so the unsafe departures form one window bounded by the extreme points of this region inside the box of valid (s, tau).
+ * These points lie either on the borders of the box or are the extreme points of the ellipse itself.
+ */
+
+#ifndef SECTIONKERNEL_H
+#define SECTIONKERNEL_H
+#include "sectionbuffer.h"
+
+void getUnsafeWindowsScalar(SectionBuffer &buffer, double pi, double pj, double vai, double vaj, double duration, double radius);
+#ifdef SECTIONS_SIMD
+void getUnsafeWindowsSse2(SectionBuffer &buffer, double pi, double pj, double vai, double vaj, double duration, double radius);
+bool getUnsafeWindowsAvx2(SectionBuffer &buffer, double pi, double pj, double vai, double vaj, double duration, double radius);
+#endif
+
+//extends [begin, end] by the part of [lo, hi] where |alpha + beta*s| < r
+template<class T>
+inline void extendByLine(typename T::V alpha_i, typename T::V alpha_j, typename T::V beta_i, typename T::V beta_j, typename T::V r2,
+                         typename T::V lo, typename T::V hi, typename T::M enabled, typename T::V &begin, typename T::V &end)
+{
+    typedef typename T::V V;
+    typedef typename T::M M;
+    V eps(T::set(CN_EPSILON));
+    V a(beta_i*beta_i + beta_j*beta_j), b(alpha_i*beta_i + alpha_j*beta_j), c(alpha_i*alpha_i + alpha_j*alpha_j - r2);
+    V dscr(b*b - a*c);
+    V root(T::sqrt(T::max(dscr, T::set(0))));
+    M flat(T::less(a, eps));
+    V from(T::select(flat, lo, T::max(lo, (-b - root)/a)));
+    V to(T::select(flat, hi, T::min(hi, (-b + root)/a)));
+    //dscr/a = r*r - (minimal distance)^2, so the line just touches the disk if it is small; touching is not a collision
+    M valid(T::select(flat, T::less(c, T::set(0)), T::less(eps*a, dscr)));
+    valid = T::both(T::both(valid, T::less(from + eps, to)), enabled);
+    begin = T::select(valid, T::min(begin, from), begin);
+    end = T::select(valid, T::max(end, to), end);
+}
+
+template<class T>
+inline void getUnsafeWindowsKernel(SectionBuffer &buffer, double pi, double pj, double vai, double vaj, double duration, double radius)
+{
+    typedef typename T::V V;
+    typedef typename T::M M;
+    V P_i(T::set(pi)), P_j(T::set(pj)), VA_i(T::set(vai)), VA_j(T::set(vaj)), D(T::set(duration));
+    V eps(T::set(CN_EPSILON)), inf(T::set(CN_INFINITY)), zero(T::set(0));
+    M all(T::less(zero, inf));
+    for(unsigned int k = 0; k < buffer.count; k += T::width)
+    {
+        V B_i(T::load(&buffer.bi[k])), B_j(T::load(&buffer.bj[k])), VB_i(T::load(&buffer.vbi[k])), VB_j(T::load(&buffer.vbj[k]));
+        V g1(T::load(&buffer.g1[k])), g2(T::load(&buffer.g2[k]));
+        V r(T::load(&buffer.sizes[k]) + T::set(radius));
+        V r2(r*r);
+        V a_i(B_i - VB_i*g1 - P_i), a_j(B_j - VB_j*g1 - P_j);
+        V v_i(VB_i - VA_i), v_j(VB_j - VA_j);
+        V begin(inf), end(-inf);
+
+        //the borders of the box: tau = 0, tau = duration, s + tau = g1, s + tau = g2
+        extendByLine<T>(a_i, a_j, VB_i, VB_j, r2, g1, g2, all, begin, end);
+        extendByLine<T>(a_i + v_i*D, a_j + v_j*D, VB_i, VB_j, r2, g1 - D, g2 - D, all, begin, end);
+        extendByLine<T>(a_i + v_i*g1, a_j + v_j*g1, VA_i, VA_j, r2, g1 - D, g1, all, begin, end);
+        extendByLine<T>(a_i + v_i*g2, a_j + v_j*g2, VA_i, VA_j, r2, g2 - D, g2, T::less(g2, inf), begin, end);
+
+        //the extreme points of the ellipse itself, if they are inside the box
+        V det(VB_i*v_j - v_i*VB_j);
+        M regular(T::less(eps, T::abs(det)));
+        V gi(v_j/det), gj(-v_i/det);
+        V len(T::sqrt(gi*gi + gj*gj));
+        for(int sign = -1; sign <= 1; sign += 2)
+        {
+            V f(T::set(sign)*r/len);
+            V d_i(gi*f - a_i), d_j(gj*f - a_j);
+            V s((v_j*d_i - v_i*d_j)/det), tau((VB_i*d_j - VB_j*d_i)/det);
+            M inside(T::both(T::both(T::notGreater(zero, tau), T::notGreater(tau, D)),
+                             T::both(T::notGreater(g1, s + tau), T::notGreater(s + tau, g2))));
+            inside = T::both(inside, regular);
+            begin = T::select(inside, T::min(begin, s), begin);
+            end = T::select(inside, T::max(end, s), end);
+        }
+        //same velocities, the region is a strip across the box
+        M parallel(T::both(T::select(regular, T::less(inf, zero), all), T::less(v_i*v_i + v_j*v_j, eps)));
+        extendByLine<T>(a_i, a_j, VB_i, VB_j, r2, g1 - D, g2, parallel, begin, end);
+
+        //the section never ends, so all the later departures are unsafe as well
+        end = T::select(T::both(T::notGreater(inf, g2), T::less(begin, inf)), inf, end);
+        T::store(&buffer.begins[k], begin);
+        T::store(&buffer.ends[k], end);
+    }
+}
+
+#endif // SECTIONKERNEL_H
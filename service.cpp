@@ -0,0 +1,312 @@
+#include "service.h"
+#include <limits>
+#ifdef __linux__
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <sys/stat.h>
+    #include <errno.h>
+    #include <unistd.h>
+    #include <string.h>
+#endif
+
+#ifdef __linux__
+//stream buffer over the connection of the socket, so the sessions of stdin and of the socket are served by the same code
+class SocketBuffer : public std::streambuf
+{
+public:
+    SocketBuffer(int fd):fd(fd)
+    {
+        setg(input, input, input);
+        setp(output, output + sizeof(output));
+    }
+    ~SocketBuffer() { sync(); }
+
+protected:
+    int underflow()
+    {
+        ssize_t n = recv(fd, input, sizeof(input), 0);
+        if(n <= 0)
+            return traits_type::eof();
+        setg(input, input, input + n);
+        return traits_type::to_int_type(input[0]);
+    }
+    int overflow(int c)
+    {
+        if(sync() != 0)
+            return traits_type::eof();
+        if(c != traits_type::eof())
+        {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+    int sync()
+    {
+        for(char *p = pbase(); p < pptr();)
+        {
+            ssize_t n = send(fd, p, pptr() - p, MSG_NOSIGNAL);
+            if(n <= 0)
+                return -1;
+            p += n;
+        }
+        setp(output, output + sizeof(output));
+        return 0;
+    }
+
+private:
+    int fd;
+    char input[4096];
+    char output[4096];
+};
+#endif
+
+Service::Service()
+{
+}
+
+Map *Service::getMap(const std::string &name, std::string &error)
+{
+    auto it = maps.find(name);
+    if(it != maps.end())
+        return it->second.get();
+    std::unique_ptr<Map> map(new Map);
+    if(!map->getMap(name.c_str()))
+    {
+        error = "can't load the map '" + name + "'";
+        return nullptr;
+    }
+    return (maps[name] = std::move(map)).get();
+}
+
+Config *Service::getConfig(const std::string &name, std::string &error)
+{
+    auto it = configs.find(name);
+    if(it != configs.end())
+        return it->second.get();
+    std::unique_ptr<Config> config(new Config);
+    if(!config->getConfig(name.c_str()))
+    {
+        error = "can't load the config '" + name + "'";
+        return nullptr;
+    }
+    return (configs[name] = std::move(config)).get();
+}
+
+std::shared_ptr<const Constraints> Service::getObstacleLayer(const std::string &mapName, const std::string &obstaclesName,
+                                                             DynamicObstacles *&obs, std::string &error)
+{
+    obs = &noObstacles;
+    if(!obstaclesName.empty())
+    {
+        auto it = obstacles.find(obstaclesName);
+        if(it == obstacles.end())
+        {
+            std::unique_ptr<DynamicObstacles> loaded(new DynamicObstacles);
+            if(!loaded->getObstacles(obstaclesName.c_str()))
+            {
+                error = "can't load the obstacles '" + obstaclesName + "'";
+                return nullptr;
+            }
+            it = obstacles.insert(std::make_pair(obstaclesName, std::move(loaded))).first;
+        }
+        obs = it->second.get();
+    }
+    std::shared_ptr<const Constraints> &layer = layers[std::make_pair(mapName, obstaclesName)];
+    if(!layer)
+        layer = AA_SIPP::buildObstacleLayer(*maps[mapName], *obs);
+    return layer;
+}
+
+void Service::printResult(const SearchResult &sr, const Task &task, std::ostream &out)
+{
+    out<<"result "<<bool(sr.agents > 0 && sr.agentsSolved == int(sr.agents))<<" "<<sr.tries<<" "<<sr.runtime<<" "<<sr.agentsSolved<<" "
+       <<sr.agents<<" "<<sr.flowtime<<" "<<sr.makespan<<"\n";
+    for(unsigned int k = 0; k < task.getNumberOfAgents(); k++)
+    {
+        const ResultPathInfo &info = sr.pathInfo[k];
+        unsigned int sections = info.pathfound ? info.sections.size() : 0;
+        out<<"agent "<<task.getAgent(k).id<<" "<<info.pathfound<<" "<<sections;
+        for(unsigned int s = 0; s < sections; s++)
+            out<<" "<<info.sections[s].j<<" "<<info.sections[s].i<<" "<<info.sections[s].g;
+        out<<"\n";
+    }
+}
+
+void Service::solve(const std::string &mapName, const std::string &configName, Task &task, const std::string &obstaclesName, std::ostream &out)
+{
+    std::string error;
+    Map *map = getMap(mapName, error);
+    Config *config = map ? getConfig(configName, error) : nullptr;
+    DynamicObstacles *obs(nullptr);
+    std::shared_ptr<const Constraints> layer = config ? getObstacleLayer(mapName, obstaclesName, obs, error) : nullptr;
+    if(!layer)
+    {
+        out<<"error "<<error<<"\n";
+        return;
+    }
+    if(task.getNumberOfAgents() == 0 || !task.validateTask(*map))
+    {
+        out<<"error invalid task\n";
+        return;
+    }
+    AA_SIPP search(*config);
+    search.setObstacleLayer(layer);
+    SearchResult sr = search.startSearch(*map, task, *obs);
+    printResult(sr, task, out);
+}
+
+bool Service::serve(std::istream &in, std::ostream &out)
+{
+    out.precision(std::numeric_limits<double>::max_digits10);
+    std::string line;
+    while(std::getline(in, line))
+    {
+        std::istringstream request(line);
+        std::string command, mapName, configName, name;
+        request>>command;
+        if(command.empty())
+            continue;
+        else if(command == "quit")
+            return true;
+        else if(command == "shutdown")
+            return false;
+        else if(command == "solve")
+        {
+            request>>mapName>>configName>>name;
+            std::string obstaclesName;
+            request>>obstaclesName;
+            Task task;
+            if(name.empty())
+                out<<"error wrong number of arguments\n";
+            else if(!task.getTask(name.c_str()))
+                out<<"error can't load the task '"<<name<<"'\n";
+            else
+                solve(mapName, configName, task, obstaclesName, out);
+        }
+        else if(command == "agents")
+        {
+            int n(-1);
+            request>>mapName>>configName>>n;
+            std::string obstaclesName;
+            request>>obstaclesName;
+            //all the lines of the agents are read even if the request is wrong, so the next request starts at the right line
+            Task task;
+            bool correct(n >= 0 && !configName.empty());
+            for(int k = 0; k < n && std::getline(in, line); k++)
+            {
+                std::istringstream values(line);
+                Agent agent;
+                agent.id = std::to_string(k);
+                double size;
+                if(!(values>>agent.start_j>>agent.start_i>>agent.goal_j>>agent.goal_i))
+                    correct = false;
+                else if(values>>size)
+                {
+                    agent.size = size;
+                    if(size <= 0 || size > 10.0)
+                        correct = false;
+                }
+                task.addAgent(agent);
+            }
+            if(!correct)
+                out<<"error wrong agents\n";
+            else
+                solve(mapName, configName, task, obstaclesName, out);
+        }
+        else if(command == "load")
+        {
+            std::string error;
+            request>>mapName;
+            if(getMap(mapName, error))
+                out<<"ok\n";
+            else
+                out<<"error "<<error<<"\n";
+        }
+        else if(command == "forget")
+        {
+            request>>name;
+            maps.erase(name);
+            configs.erase(name);
+            obstacles.erase(name);
+            for(auto it = layers.begin(); it != layers.end();)
+                if(it->first.first == name || it->first.second == name)
+                    it = layers.erase(it);
+                else
+                    ++it;
+            out<<"ok\n";
+        }
+        else
+            out<<"error unknown request '"<<command<<"'\n";
+        out.flush();
+    }
+    return true;
+}
+
+void Service::runStdin()
+{
+    std::ostream out(std::cout.rdbuf());
+    std::streambuf *console = std::cout.rdbuf(std::cerr.rdbuf());
+    serve(std::cin, out);
+    out.flush();
+    std::cout.rdbuf(console);
+}
+
+bool Service::runSocket(const char *socketName)
+{
+#ifdef __linux__
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(strlen(socketName) >= sizeof(address.sun_path))
+    {
+        std::cout<<"Error! The name of the socket '"<<socketName<<"' is too long.\n";
+        return false;
+    }
+    strcpy(address.sun_path, socketName);
+    struct stat existing;
+    if(lstat(socketName, &existing) == 0)//only a socket left by the previous run is replaced, any other file is kept
+    {
+        if(!S_ISSOCK(existing.st_mode))
+        {
+            std::cout<<"Error! '"<<socketName<<"' already exists and is not a socket.\n";
+            return false;
+        }
+        unlink(socketName);
+    }
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(server < 0 || bind(server, (sockaddr*)&address, sizeof(address)) != 0 || listen(server, 16) != 0)
+    {
+        std::cout<<"Error! Can't listen to the socket '"<<socketName<<"'.\n";
+        if(server >= 0)
+            close(server);
+        return false;
+    }
+    std::cout<<"LISTENING "<<socketName<<std::endl;
+    bool running(true), failed(false);
+    while(running)
+    {
+        int client = accept(server, nullptr, nullptr);
+        if(client < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            std::cout<<"Error! Can't accept a connection to the socket '"<<socketName<<"': "<<strerror(errno)<<".\n";
+            failed = true;
+            break;
+        }
+        {
+            SocketBuffer buffer(client);
+            std::iostream stream(&buffer);
+            running = serve(stream, stream);
+        }
+        close(client);
+    }
+    close(server);
+    unlink(socketName);
+    return !failed;
+#else
+    std::cout<<"Error! Unix domain sockets are not supported on this platform, the requests can be sent through stdin.\n";
+    return false;
+#endif
+}
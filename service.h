@@ -0,0 +1,61 @@
+/* This class runs the planner as a long-living process that answers the requests of a client line by line,
+ * either through stdin/stdout or through a Unix domain socket. The maps, configs and dynamic obstacles are loaded
+ * from their files by the first request that needs them and stay in memory together with the caches of the maps
+ * and the constraints of the obstacles, so the next requests only pay for the search itself.
+ * The trajectories are returned to the client, no log-files are written.
+ *
+ * Requests:
+ *   solve <map-file> <config-file> <task-file> [obstacles-file]
+ *   agents <map-file> <config-file> <n> [obstacles-file], followed by n lines "start.x start.y goal.x goal.y [size]"
+ *   load <map-file> - loads the map in advance
+ *   forget <file> - drops the loaded map, config or obstacles, so they are read again from the changed file
+ *   quit - ends the session; shutdown - also stops listening to the socket
+ * Responses:
+ *   ok
+ *   error <message>
+ *   result <solved> <tries> <runtime> <agents solved> <agents> <flowtime> <makespan>, followed by one line per agent
+ *   "agent <id> <path found> <number of sections> x y g x y g ..." with the positions and the times of the trajectory
+ */
+
+#ifndef SERVICE_H
+#define SERVICE_H
+
+#include "map.h"
+#include "config.h"
+#include "searchresult.h"
+#include "aa_sipp.h"
+#include "task.h"
+#include "dynamicobstacles.h"
+#include <string>
+#include <map>
+#include <memory>
+#include <iostream>
+#include <sstream>
+
+class Service
+{
+public:
+    Service();
+    //answers the requests until 'quit', 'shutdown' or the end of the input, returns false after 'shutdown'
+    bool serve(std::istream &in, std::ostream &out);
+    //the protocol takes the standard output, so all the other messages of the planner are redirected to stderr
+    void runStdin();
+    //serves the clients of the socket one after another, until 'shutdown'
+    bool runSocket(const char *socketName);
+
+private:
+    Map *getMap(const std::string &name, std::string &error);
+    Config *getConfig(const std::string &name, std::string &error);
+    std::shared_ptr<const Constraints> getObstacleLayer(const std::string &mapName, const std::string &obstaclesName,
+                                                        DynamicObstacles *&obstacles, std::string &error);
+    void solve(const std::string &mapName, const std::string &configName, Task &task, const std::string &obstaclesName, std::ostream &out);
+    void printResult(const SearchResult &sr, const Task &task, std::ostream &out);
+
+    std::map<std::string, std::unique_ptr<Map>> maps;
+    std::map<std::string, std::unique_ptr<Config>> configs;
+    std::map<std::string, std::unique_ptr<DynamicObstacles>> obstacles;
+    std::map<std::pair<std::string, std::string>, std::shared_ptr<const Constraints>> layers; //by the names of the map and obstacles
+    DynamicObstacles noObstacles;
+};
+
+#endif
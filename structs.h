@@ -59,17 +59,39 @@ struct SafeInterval
 
 struct Node
 {
-    Node(int _i=-1, int _j=-1, double _g=-1, double _F=-1):i(_i),j(_j),g(_g),F(_F),Parent(nullptr){}
-    ~Node(){ Parent = nullptr; }
+    Node(int _i=-1, int _j=-1, double _g=-1, double _F=-1):i(_i),j(_j),g(_g),F(_F),Parent(-1){}
     int     i, j;
     double  size;
     double  g;
     double  F;
     double  heading;
-    Node*   Parent;
+    int     Parent; //index of the parent node in CLOSE, -1 if there is no parent
     SafeInterval interval;
 };
 
+struct SearchNode //compact node that is used by the search, paths are built of 'Node' structures
+{
+    SearchNode(int _i=-1, int _j=-1, double _g=-1, double _F=-1)
+        :g(_g), F(_F), heading(0), interval_end(CN_INFINITY), i(_i), j(_j), Parent(-1), interval_id(0){}
+    double  g;
+    double  F;
+    double  heading;
+    double  interval_end;
+    int     i, j;
+    int     Parent;      //index of the parent node in CLOSE, -1 if there is no parent
+    int     interval_id; //id of the safe interval of the cell (i,j) the node belongs to
+    void setInterval(const SafeInterval &interval) { interval_id = interval.id; interval_end = interval.end; }
+    Node toNode() const
+    {
+        Node node(i, j, g, F);
+        node.heading = heading;
+        node.Parent = Parent;
+        node.interval.end = interval_end;
+        node.interval.id = interval_id;
+        return node;
+    }
+};
+
 struct obstacle
 {
     std::string id;
@@ -82,8 +104,8 @@ struct obstacle
 struct section
 {
     section(int _i1=-1, int _j1=-1, int _i2=-1, int _j2=-1, double _g1=-1, double _g2=-1)
-        :i1(_i1), j1(_j1), i2(_i2), j2(_j2), g1(_g1), g2(_g2){}
-    section(const Node &a, const Node &b):i1(a.i), j1(a.j), i2(b.i), j2(b.j), g1(a.g), g2(b.g){}
+        :i1(_i1), j1(_j1), i2(_i2), j2(_j2), g1(_g1), g2(_g2), id(-1){}
+    section(const Node &a, const Node &b):i1(a.i), j1(a.j), i2(b.i), j2(b.j), g1(a.g), g2(b.g), id(-1){}
     int i1;
     int j1;
     int i2;
@@ -92,6 +114,7 @@ struct section
     double g1;
     double g2;//is needed for goal and wait actions
     double mspeed;
+    int id;//the same section is stored in all the cells it sweeps, id is used to tell the copies of it
     bool operator == (const section &comp) const {return (i1 == comp.i1 && j1 == comp.j1 && g1 == comp.g1);}
 
 };
@@ -132,33 +132,41 @@ bool Task::getTask(const char *fileName)
 
 bool Task::validateTask(const Map &map)
 {
-    LineOfSight los;
-    for(Agent a:agents)
+    std::string error;
+    if(validateTask(map, error))
+        return true;
+    std::cout<<"Error! "<<error<<"\n";
+    return false;
+}
+
+bool Task::validateTask(const Map &map, std::string &error) const
+{
+    for(const Agent &a:agents)
     {
-        los.setSize(a.size);
+        const LineOfSight &los = LineOfSight::get(a.size);
         if(!los.checkTraversability(a.start_i, a.start_j, map))
         {
-            std::cout<<"Error! Start position of agent "<<a.id<<" is invalid.\n";
+            error = "Start position of agent " + a.id + " is invalid.";
             return false;
         }
         if(!los.checkTraversability(a.goal_i, a.goal_j, map))
         {
-            std::cout<<"Error! Goal position of agent "<<a.id<<" is invalid.\n";
+            error = "Goal position of agent " + a.id + " is invalid.";
             return false;
         }
     }
-    for(int i = 0; i < agents.size(); i++)
-        for(int j = i + 1; j < agents.size(); j++)
+    for(unsigned int i = 0; i < agents.size(); i++)
+        for(unsigned int j = i + 1; j < agents.size(); j++)
         {
-            Agent a1 = agents[i], a2 = agents[j];
+            const Agent &a1 = agents[i], &a2 = agents[j];
             if(sqrt(pow(a1.start_i - a2.start_i, 2) + pow(a1.start_j - a2.start_j, 2)) < (a1.size + a2.size))
             {
-                std::cout<<"Error! Start positions of agents "<< a1.id <<" and "<< a2.id <<" are placed too close.\n";
+                error = "Start positions of agents " + a1.id + " and " + a2.id + " are placed too close.";
                 return false;
             }
             if(sqrt(pow(a1.goal_i - a2.goal_i, 2) + pow(a1.goal_j - a2.goal_j, 2)) < (a1.size + a2.size))
             {
-                std::cout<<"Error! Goal positions of agents "<< a1.id <<" and "<< a2.id <<" are placed too close.\n";
+                error = "Goal positions of agents " + a1.id + " and " + a2.id + " are placed too close.";
                 return false;
             }
         }
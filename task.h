@@ -14,9 +14,11 @@ class Task
 public:
     Task(){}
     bool getTask(const char* fileName);
+    void addAgent(const Agent &agent) { agents.push_back(agent); }
     Agent getAgent(unsigned int id) const;
     unsigned int getNumberOfAgents() const;
-    bool validateTask(const Map &map);
+    bool validateTask(const Map &map); //prints the error if the task is invalid
+    bool validateTask(const Map &map, std::string &error) const;
 };
 
 #endif // TASK_H